@@ -0,0 +1,191 @@
+#include "FlareLoader.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+// Walks a Flare level line by line, keeping the line number and start for error messages
+class FlareParser {
+public:
+	FlareParser(const std::string& file, const char* begin, const char* end, GameState* state) :
+		file(file), position(begin), end(end), lineStart(begin), line(1), state(state), width(0), height(0), haveLayer(false) {}
+
+	bool Parse() {
+		std::string_view text;
+		while (NextLine(text)) {
+			if (text.empty() || text[0] == '#') continue;
+			if (text == "[header]") {
+				if (!ParseHeader()) return false;
+			}
+			else if (text == "[layer]") {
+				if (!ParseLayer()) return false;
+			}
+			else if (text == "[Object Layer]") {
+				if (!ParseObject()) return false;
+			}
+			else if (text[0] == '[') {
+				while (NextLine(text) && !text.empty()) {}
+			}
+			else {
+				return Error(text.data(), "expected a [section]");
+			}
+		}
+		if (!haveLayer) return Error(position, "no [layer] section");
+		return true;
+	}
+
+private:
+	// The next line without its line break, false at the end of the file. The break itself is
+	// left for the following call so line and lineStart always describe the current line.
+	bool NextLine(std::string_view& text) {
+		if (position < end && *position == '\n') NewLine();
+		if (position >= end) return false;
+		const char* begin = position;
+		const char* newline = (const char*)memchr(position, '\n', end - position);
+		position = newline ? newline : end;
+		const char* finish = position;
+		if (finish > begin && finish[-1] == '\r') --finish;
+		text = std::string_view(begin, finish - begin);
+		return true;
+	}
+
+	void NewLine() {
+		++position;
+		++line;
+		lineStart = position;
+	}
+
+	// Splits key=value skipping # comments, a section ends at an empty line
+	bool NextKey(std::string_view& key, std::string_view& value, bool& done) {
+		std::string_view text;
+		do {
+			done = !NextLine(text) || text.empty();
+			if (done) return true;
+		} while (text[0] == '#');
+		size_t equals = text.find('=');
+		if (equals == std::string_view::npos) return Error(text.data(), "expected key=value");
+		key = text.substr(0, equals);
+		value = text.substr(equals + 1);
+		return true;
+	}
+
+	bool Integer(std::string_view text, int& value) {
+		const char* finish = text.data() + text.size();
+		std::from_chars_result result = std::from_chars(text.data(), finish, value);
+		if (result.ec != std::errc()) return Error(text.data(), "expected a number");
+		if (result.ptr != finish) return Error(result.ptr, "unexpected character after number");
+		return true;
+	}
+
+	bool ParseHeader() {
+		std::string_view key, value;
+		bool done;
+		while (NextKey(key, value, done)) {
+			if (done) break;
+			if (key == "width" || key == "height") {
+				int& size = key == "width" ? width : height;
+				if (!Integer(value, size)) return false;
+				if (size <= 0) return Error(value.data(), "size must be positive");
+			}
+		}
+		if (!done) return false;
+		if (width <= 0 || height <= 0) return Error(lineStart, "[header] is missing width or height");
+		state->tiles.Resize(width, height);
+		return true;
+	}
+
+	bool ParseLayer() {
+		if (width <= 0) return Error(lineStart, "[layer] before [header]");
+		TileLayer* layer = &state->tiles;
+		if (haveLayer) {
+			state->overlayLayers.emplace_back();
+			layer = &state->overlayLayers.back();
+			layer->Resize(width, height);
+		}
+		haveLayer = true;
+		std::string_view key, value;
+		bool done;
+		while (NextKey(key, value, done)) {
+			if (done) return true;
+			if (key == "data" && !ParseTiles(*layer)) return false;
+		}
+		return false;
+	}
+
+	static bool isSeparator(char c) { return c == ',' || c == ' ' || c == '\t' || c == '\r'; }
+
+	// width * height ids starting on the line after data=, rows end with an optional comma
+	bool ParseTiles(TileLayer& layer) {
+		uint16_t* tiles = layer.Data();
+		size_t count = layer.Size();
+		for (size_t i = 0; i < count; i++) {
+			while (position < end && (isSeparator(*position) || *position == '\n')) {
+				if (*position == '\n') NewLine();
+				else ++position;
+			}
+			unsigned int id;
+			std::from_chars_result result = std::from_chars(position, end, id);
+			if (result.ec != std::errc()) {
+				return Error(position, "expected tile " + std::to_string(i + 1) + " of " + std::to_string(width) + "x" + std::to_string(height));
+			}
+			if (id > 0xFFFF + 1) return Error(position, "tile id out of range");
+			// be careful, the tiles in this format are indexed from 1 not 0
+			tiles[i] = id > 0 ? (uint16_t)(id - 1) : 0;
+			position = result.ptr;
+		}
+		while (position < end && isSeparator(*position)) ++position;
+		if (position < end && *position != '\n') return Error(position, "more tiles than width x height");
+		return true;
+	}
+
+	bool ParseObject() {
+		std::string_view type;
+		std::string_view key, value;
+		bool done;
+		while (NextKey(key, value, done)) {
+			if (done) return true;
+			if (key == "type") {
+				type = value;
+			}
+			else if (key == "location") {
+				// x,y,width,height in tiles, only the position is used
+				size_t comma = value.find(',');
+				if (comma == std::string_view::npos) return Error(value.data(), "expected x,y");
+				size_t next = value.find(',', comma + 1);
+				int x, y;
+				if (!Integer(value.substr(0, comma), x) || !Integer(value.substr(comma + 1, next == std::string_view::npos ? next : next - comma - 1), y)) return false;
+				placeEntity(std::string(type), state, (float)x, (float)-y);
+			}
+		}
+		return false;
+	}
+
+	bool Error(const char* at, const std::string& message) {
+		std::cout << file << ":" << line << ":" << (at - lineStart) + 1 << ": " << message << std::endl;
+		return false;
+	}
+
+	const std::string& file;
+	const char* position;
+	const char* end;
+	const char* lineStart;
+	int line;
+	GameState* state;
+	int width;
+	int height;
+	bool haveLayer;
+};
+
+bool LoadFlareLevel(const std::string& levelFile, GameState* state) {
+	PROFILE_SCOPE("LoadFlareLevel");
+	MappedFile file;
+	if (!file.Open(levelFile)) {
+		std::cout << "Unable to open level " << levelFile << std::endl;
+		return false;
+	}
+	const char* text = (const char*)file.Data();
+	FlareParser parser(levelFile, text, text + file.Size(), state);
+	return parser.Parse();
+}
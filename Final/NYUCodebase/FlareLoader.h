@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include "Game.h"
+
+// Reads a Flare text export into state straight out of the mapped file, without copying lines.
+// Sections are [header] (width and height), [layer] (type and data rows of 1-based tile ids) and
+// [Object Layer] (type and location in tiles); anything else, like [tilesets], is skipped. The
+// first layer becomes state->tiles and any further ones state->overlayLayers.
+//
+// Malformed input is reported as file:line:column and fails the load.
+bool LoadFlareLevel(const std::string& levelFile, GameState* state);
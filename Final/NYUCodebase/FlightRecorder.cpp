@@ -0,0 +1,42 @@
+#include "FlightRecorder.h"
+#include <cstdio>
+#include <iostream>
+
+FlightRecorder::FlightRecorder(size_t capacity, float budgetMs) :
+	budgetMs(budgetMs), cooldown(capacity), spikes(0), records(capacity), count(0), frame(0), lastDump(0) {}
+
+FrameRecord& FlightRecorder::Next() {
+	FrameRecord& record = records[frame % records.size()];
+	record = FrameRecord();
+	record.frame = frame;
+	return record;
+}
+
+void FlightRecorder::Commit(const FrameRecord& record) {
+	++frame;
+	if (count < records.size()) ++count;
+	if (record.elapsedMs <= budgetMs) return;
+	++spikes;
+	if (lastDump != 0 && frame - lastDump < cooldown) return;
+	lastDump = frame;
+	Dump("spike_" + std::to_string(record.frame) + ".csv");
+}
+
+bool FlightRecorder::Dump(const std::string& file) const {
+	FILE* out = fopen(file.c_str(), "w");
+	if (out == NULL) {
+		std::cout << "Unable to write " << file << std::endl;
+		return false;
+	}
+	fputs("frame,elapsedMs,steps,accumulator,inputMs,updateMs,renderMs,swapMs,entities,drawCalls,sprites,skippedGLCalls,input\n", out);
+	// oldest first
+	for (size_t i = 0; i < count; ++i) {
+		const FrameRecord& r = records[(frame - count + i) % records.size()];
+		fprintf(out, "%lu,%.3f,%d,%.5f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%s%s%s%s%s\n", r.frame, r.elapsedMs, r.steps, r.accumulator,
+			r.inputMs, r.updateMs, r.renderMs, r.swapMs, r.entities, r.drawCalls, r.sprites, r.skippedGLCalls,
+			r.input.left ? "L" : "", r.input.right ? "R" : "", r.input.jump ? "J" : "", r.input.keyPressed ? "K" : "", r.input.quit ? "Q" : "");
+	}
+	fclose(out);
+	std::cout << "Frame over " << budgetMs << "ms budget, wrote the last " << count << " frames to " << file << std::endl;
+	return true;
+}
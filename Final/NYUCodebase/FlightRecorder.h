@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Game.h"
+
+// What one frame of the main loop did and how long each part took
+struct FrameRecord {
+	unsigned long frame;
+	// wall time since the previous frame started, including the wait
+	float elapsedMs;
+	int steps;
+	// seconds left in the fixed step accumulator after stepping
+	float accumulator;
+	float inputMs;
+	float updateMs;
+	float renderMs;
+	float swapMs;
+	int entities;
+	int drawCalls;
+	int sprites;
+	// GL calls the state cache found already in effect
+	int skippedGLCalls;
+	InputState input;
+};
+
+// Always-on history of the last frames. Filling a record is a handful of stores into a ring
+// allocated up front, nothing touches the disk until a frame runs over budget, at which point the
+// whole history leading up to it is written out as spike_<frame>.csv.
+class FlightRecorder {
+public:
+	FlightRecorder(size_t capacity, float budgetMs);
+
+	// The slot for the frame about to be recorded, overwriting the oldest
+	FrameRecord& Next();
+	// Checks the record Next() returned against the budget and dumps the history on a spike
+	void Commit(const FrameRecord& record);
+	bool Dump(const std::string& file) const;
+
+	// frames slower than this are spikes
+	float budgetMs;
+	// spikes within this many frames of the last dump are left for the next one
+	size_t cooldown;
+	unsigned long spikes;
+
+private:
+	std::vector<FrameRecord> records;
+	size_t count;
+	unsigned long frame;
+	unsigned long lastDump;
+};
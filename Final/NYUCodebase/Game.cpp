@@ -0,0 +1,401 @@
+#include "Game.h"
+#include "Profiler.h"
+#include "LevelFile.h"
+#include "TmxLoader.h"
+#include "FlareLoader.h"
+#include "StateLoader.h"
+#include "Integrator.h"
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cstring>
+#include <random>
+
+// mt19937 gives the same sequence on every platform, unlike rand()
+static std::mt19937 gameRandom;
+
+EntityHandle EntityStore::Create(ENTITY_TYPE entityType, const SheetSprite& sprite, float placeX, float placeY) {
+	size_t index;
+	if (freeSlots.empty()) {
+		index = Size();
+		x.push_back(0.0f); y.push_back(0.0f);
+		previousX.push_back(0.0f); previousY.push_back(0.0f);
+		velocityX.push_back(0.0f); velocityY.push_back(0.0f);
+		width.push_back(0.0f); height.push_back(0.0f);
+		type.push_back(0); alive.push_back(0); contact.push_back(0);
+		detail.emplace_back();
+		generation.push_back(0);
+		used.push_back(0);
+	}
+	else {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	x[index] = previousX[index] = placeX;
+	y[index] = previousY[index] = placeY;
+	velocityX[index] = velocityY[index] = 0.0f;
+	width[index] = height[index] = 1.0f;
+	type[index] = (uint8_t)entityType;
+	alive[index] = true;
+	contact[index] = 0;
+	detail[index] = EntityDetail();
+	detail[index].sprite = sprite;
+	if (entityType == ENTITY_BOSS) detail[index].health = 5;
+	used[index] = 1;
+	return Handle(index);
+}
+
+void EntityStore::Destroy(EntityHandle handle) {
+	if (!Valid(handle)) return;
+	alive[handle.index] = false;
+	used[handle.index] = 0;
+	// any handle still out there no longer matches
+	++generation[handle.index];
+	detail[handle.index].frames.clear();
+	freeSlots.push_back(handle.index);
+}
+
+bool EntityStore::Valid(EntityHandle handle) const {
+	return handle.index < Size() && used[handle.index] && generation[handle.index] == handle.generation;
+}
+
+void EntityStore::Reserve(size_t count) {
+	x.reserve(count); y.reserve(count);
+	previousX.reserve(count); previousY.reserve(count);
+	velocityX.reserve(count); velocityY.reserve(count);
+	width.reserve(count); height.reserve(count);
+	type.reserve(count); alive.reserve(count); contact.reserve(count);
+	detail.reserve(count);
+	generation.reserve(count);
+	used.reserve(count);
+}
+
+bool isCollidingRect(const EntityStore& entities, size_t r1, size_t r2){
+	const std::vector<float>& x = entities.x;
+	const std::vector<float>& y = entities.y;
+	const std::vector<float>& height = entities.height;
+	// Is r1 bottom > r2 top?
+	if (y[r1] - height[r1] / 2 > y[r2] + height[r2] / 2) return false;
+	// Is r1 top < r2 bottom?
+	if (y[r1] + height[r1] / 2 < y[r2] - height[r2] / 2) return false;
+	// Is r1 left > r2 right?
+	if (x[r1] - height[r1] / 2 > x[r2] + height[r2] / 2) return false;
+	// Is r1 right < r2 left?
+	if (x[r1] + height[r1] / 2 < x[r2] - height[r2] / 2) return false;
+
+	return true;
+}
+
+// Game levels use one world unit per tile, x grows right from 0 and rows grow down from y = 0
+int tileColumn(float worldX) {
+	return (int)floorf(worldX);
+}
+
+int tileRow(float worldY) {
+	return (int)floorf(-worldY);
+}
+
+// Resolves entity ent against only the tiles its bounding box overlaps. The vertical pass uses the
+// columns it spanned at previousX, then the horizontal pass uses the rows it spans after that
+// correction, so each axis is pushed out on its own and all four contact bits are filled.
+void resolveTileCollisions(GameState* state, size_t ent, float previousX) {
+	// keeps a box resting flush against a wall or floor from counting as overlapping it on the other axis
+	const float skin = 0.001f;
+	const TileProperties& properties = *state->tileProperties;
+	const TileLayer& tiles = state->tiles;
+	EntityStore& entities = state->entities;
+	float& x = entities.x[ent];
+	float& y = entities.y[ent];
+	float halfWidth = entities.width[ent] / 2;
+	float halfHeight = entities.height[ent] / 2;
+	uint8_t contact = 0;
+
+	int left = std::max(tileColumn(previousX - halfWidth + skin), 0);
+	int right = std::min(tileColumn(previousX + halfWidth - skin), tiles.Width() - 1);
+	int top = std::max(tileRow(y + halfHeight), 0);
+	int bottom = std::min(tileRow(y - halfHeight), tiles.Height() - 1);
+	float floorTop = -FLT_MAX;
+	float ceilingBottom = FLT_MAX;
+	for (int row = top; row <= bottom; ++row) {
+		const uint16_t* tile = tiles.Row(row);
+		for (int column = left; column <= right; ++column) {
+			if (!properties.IsSolid(tile[column])) continue;
+			if (y >= -row - 0.5f) { floorTop = std::max(floorTop, (float)-row); contact |= EntityStore::CONTACT_BOTTOM; }
+			else { ceilingBottom = std::min(ceilingBottom, (float)-row - 1.0f); contact |= EntityStore::CONTACT_TOP; }
+			if (properties.IsHazard(tile[column])) entities.alive[ent] = false;
+		}
+	}
+	if (contact & EntityStore::CONTACT_BOTTOM) y = floorTop + halfHeight;
+	else if (contact & EntityStore::CONTACT_TOP) y = ceilingBottom - halfHeight - 0.00001f;
+	if (contact & (EntityStore::CONTACT_TOP | EntityStore::CONTACT_BOTTOM)) entities.velocityY[ent] = 0;
+
+	left = std::max(tileColumn(x - halfWidth), 0);
+	right = std::min(tileColumn(x + halfWidth), tiles.Width() - 1);
+	top = std::max(tileRow(y + halfHeight - skin), 0);
+	bottom = std::min(tileRow(y - halfHeight + skin), tiles.Height() - 1);
+	float wallLeft = FLT_MAX;
+	float wallRight = -FLT_MAX;
+	for (int row = top; row <= bottom; ++row) {
+		const uint16_t* tile = tiles.Row(row);
+		for (int column = left; column <= right; ++column) {
+			if (!properties.IsSolid(tile[column])) continue;
+			if (x < column + 0.5f) { wallLeft = std::min(wallLeft, (float)column); contact |= EntityStore::CONTACT_RIGHT; }
+			else { wallRight = std::max(wallRight, column + 1.0f); contact |= EntityStore::CONTACT_LEFT; }
+			if (properties.IsHazard(tile[column])) entities.alive[ent] = false;
+		}
+	}
+	if (contact & EntityStore::CONTACT_RIGHT) {
+		x = std::min(x, wallLeft - halfWidth);
+		if (entities.velocityX[ent] > 0) entities.velocityX[ent] = 0;
+	}
+	else if (contact & EntityStore::CONTACT_LEFT) {
+		x = std::max(x, wallRight + halfWidth);
+		if (entities.velocityX[ent] < 0) entities.velocityX[ent] = 0;
+	}
+	entities.contact[ent] = contact;
+}
+
+float lerp(float v0, float v1, float t) {
+	return (1.0 - t)*v0 + t*v1;
+}
+
+void SeedRandom(uint32_t seed) {
+	gameRandom.seed(seed);
+}
+
+float randf(float a, float b) {
+	float random = (float)(gameRandom() / (double)std::mt19937::max());
+	float diff = b - a;
+	float r = random * diff;
+	return a + r;
+}
+
+bool parseEntityType(const std::string& name, EntityStore::ENTITY_TYPE& type) {
+	if (name == "Player") type = EntityStore::ENTITY_PLAYER;
+	else if (name == "Snail") type = EntityStore::ENTITY_SNAIL;
+	else if (name == "Fly") type = EntityStore::ENTITY_FLY;
+	else if (name == "Boss") type = EntityStore::ENTITY_BOSS;
+	else return false;
+	return true;
+}
+
+void placeEntity(std::string type, GameState* state, float placeX, float placeY) {
+	EntityStore::ENTITY_TYPE entityType;
+	if (!parseEntityType(type, entityType)) {
+		std::cout << "Skipping entity of unknown type " << type << std::endl;
+		return;
+	}
+	placeEntity(entityType, state, placeX, placeY);
+}
+
+void placeEntity(EntityStore::ENTITY_TYPE entityType, GameState* state, float placeX, float placeY) {
+	state->entities.Create(entityType, state->sprites[entityType], placeX, placeY);
+}
+
+static bool hasExtension(const std::string& file, const char* extension) {
+	size_t length = strlen(extension);
+	return file.size() >= length && file.compare(file.size() - length, length, extension) == 0;
+}
+
+bool LoadLevel(const std::string& levelFile, GameState* state) {
+	if (hasExtension(levelFile, ".lvl")) {
+		if (LoadCompiledLevel(levelFile, state)) return true;
+		std::cout << "Unable to open level " << levelFile << std::endl;
+		return false;
+	}
+	if (hasExtension(levelFile, ".tmx")) return LoadTmxLevel(levelFile, state);
+	return LoadFlareLevel(levelFile, state);
+}
+
+// Every entity sprite on the 694x372 tile sheet, worked out by the compiler
+static constexpr std::array<float, 4> playerUV = pxToUV(694, 372, 3 + 21 * 19 + 19 * 2, 3 + 21 * 0, 21, 21);
+static constexpr std::array<float, 4> snailUV = pxToUV(694, 372, 3 + 21 * 14 + 2 * 14, 3 + 21 * 15 + 2 * 15, 21, 21);
+static constexpr std::array<float, 4> flyUV = pxToUV(694, 372, 3 + 21 * 13 + 2 * 13, 3 + 21 * 14 + 2 * 14, 21, 21);
+static constexpr std::array<float, 4> bossUV = pxToUV(694, 372, 3 + 21 * 19 + 19 * 2, 3 + 21 * 2 + 2 * 2, 21, 21);
+static constexpr std::array<float, 4> playerFrameUVs[] = {
+	pxToUV(694, 372, 3 + 21 * 19 + 20 * 2, 3 + 21 * 0, 21, 21),
+	pxToUV(694, 372, 3 + 21 * 28 + 28 * 2, 3 + 21 * 0, 21, 21),
+	pxToUV(694, 372, 3 + 21 * 29 + 29 * 2, 3 + 21 * 0, 21, 21),
+};
+static constexpr std::array<float, 4> flyFrameUVs[] = {
+	flyUV,
+	pxToUV(694, 372, 3 + 21 * 14 + 2 * 13, 3 + 21 * 14 + 2 * 14, 21, 21),
+};
+static constexpr std::array<float, 4> bossFrameUVs[] = {
+	pxToUV(694, 372, 3 + 21 * 28 + 28 * 2, 3 + 21 * 2 + 2 * 2, 21, 21),
+	pxToUV(694, 372, 3 + 21 * 29 + 29 * 2, 3 + 21 * 2 + 2 * 2, 21, 21),
+};
+static_assert(playerUV[2] == 21.0f / 694 && playerUV[3] == 21.0f / 372, "entity sprites are one 21 pixel tile");
+static_assert(bossFrameUVs[1][0] + bossFrameUVs[1][2] <= 1.0f, "the last boss frame is on the sheet");
+static_assert((Vector(1.0f, 2.0f, 3.0f) + Vector(1.0f, 1.0f, 1.0f) * 2.0f).y == 4.0f, "vector math folds too");
+
+void AssignLevelSprites(GameState* state) {
+	state->sprites[EntityStore::ENTITY_PLAYER] = SheetSprite(state->tileTexture, playerUV, 1.0f);
+	state->sprites[EntityStore::ENTITY_SNAIL] = SheetSprite(state->tileTexture, snailUV, 1.0f);
+	state->sprites[EntityStore::ENTITY_FLY] = SheetSprite(state->tileTexture, flyUV, 1.0f);
+	state->sprites[EntityStore::ENTITY_BOSS] = SheetSprite(state->tileTexture, bossUV, 1.0f);
+}
+
+void AssignEntityFrames(GameState* state) {
+	std::vector<EntityDetail>& detail = state->entities.detail;
+	for (const std::array<float, 4>& uv : playerFrameUVs) {
+		detail[0].frames.push_back(SheetSprite(state->tileTexture, uv, 1.0f));
+	}
+	if(state->entities.type[1] == EntityStore::ENTITY_FLY) {
+		for (int j = 1; j < 4; ++j) {
+			for (const std::array<float, 4>& uv : flyFrameUVs) {
+				detail[j].frames.push_back(SheetSprite(state->tileTexture, uv, 1.0f));
+			}
+		}
+	}
+	else if(state->entities.type[1] == EntityStore::ENTITY_BOSS){
+		for (const std::array<float, 4>& uv : bossFrameUVs) {
+			detail[1].frames.push_back(SheetSprite(state->tileTexture, uv, 1.0f));
+		}
+	}
+}
+
+// Moves to another state, staying put if it fails to load
+static void changeState(GameState*& currentState, StateLoader& states, size_t index) {
+	GameState* next = states.Enter(index);
+	if (next) currentState = next;
+}
+
+void ProcessInput(const InputState& input, bool& done, GameState*& currentState, StateLoader& states, AudioSink& audio) {
+	PROFILE_SCOPE("ProcessInput");
+	switch(currentState->type)
+	{
+	case GameState::STATE_TYPE::STATE_MENU:
+		if (input.quit) done = true;
+		if (input.keyPressed) changeState(currentState, states, states.Find(GameState::STATE_GAME));
+		break;
+	case GameState::STATE_TYPE::STATE_GAME: {
+		// the player is always entity 0 and the level's first enemy entity 1
+		EntityStore& entities = currentState->entities;
+		EntityDetail& player = entities.detail[0];
+		// Win or Lose
+		if (entities.alive[0] == false) changeState(currentState, states, states.Find(GameState::STATE_WIN));
+		else if (entities.alive[1] == false && entities.type[1] == EntityStore::ENTITY_BOSS) changeState(currentState, states, states.Find(GameState::STATE_LOSE));
+		else {
+			if (input.quit) done = true;
+			else if (input.jump && entities.alive[0] && (entities.contact[0] & EntityStore::CONTACT_BOTTOM)) {
+				audio.Play(SOUND_JUMP);
+				entities.velocityY[0] = 6;
+			}
+
+			// Held keys
+			if (input.right && entities.x[0] + entities.width[0] / 2 < 40) {
+				entities.velocityX[0] = 3;
+				if (player.frame == 0 || player.frame == 1) { ++player.frame;  player.sprite = player.frames[2]; }
+				else if (player.frame == 2) {
+					--player.frame;
+					player.sprite = player.frames[1];
+				}
+			}
+			if (input.left && entities.x[0] - entities.width[0] / 2 > 0.0f) {
+				entities.velocityX[0] = -3;
+				if (player.frame == 0 || player.frame == 1) { ++player.frame;  player.sprite = player.frames[2]; }
+				else if (player.frame == 2) {
+					--player.frame;
+					player.sprite = player.frames[1];
+				}
+			}
+			// off the right edge into the next level, the last one ends with its boss
+			size_t next = states.Current() + 1;
+			if (next < states.Count() && states.Type(next) == GameState::STATE_GAME && entities.x[0] + entities.width[0] / 2 >= 40) {
+				changeState(currentState, states, next);
+			}
+		}
+		break;
+	}
+	case GameState::STATE_TYPE::STATE_LOSE: {}
+	case GameState::STATE_TYPE::STATE_WIN: {
+		if (input.quit) done = true;
+		break;
+	}
+	}
+}
+
+void Update(GameState* state, float elapsed, float ticks, AudioSink& audio) {
+	PROFILE_SCOPE("Update");
+	EntityStore& entities = state->entities;
+	entities.previousX = entities.x;
+	entities.previousY = entities.y;
+	switch(state->type) {
+	case GameState::STATE_TYPE::STATE_GAME: {
+		if (entities.y[0] < -15) entities.Hit(0);
+		if(entities.type[1] == EntityStore::ENTITY_SNAIL) entities.velocityX[1] = -1;
+		// Boss Behavior
+		else if(entities.type[1] == EntityStore::ENTITY_BOSS) {
+			const size_t player = 0;
+			const size_t boss = 1;
+			EntityDetail& bossDetail = entities.detail[boss];
+			int health = bossDetail.health;
+			if (entities.x[player] - randf(2.0f, 6.0f) > entities.x[boss]) entities.velocityX[boss] = 3.0f + (5-health)/2;
+			else if (entities.x[player] + randf(2.0f, 6.0f) < entities.x[boss]) entities.velocityX[boss] = -3.0f - (5-health)/2;
+			bool grounded = (entities.contact[boss] & EntityStore::CONTACT_BOTTOM) != 0;
+			if (health < 4 && entities.x[boss] < entities.x[player] + 1 && entities.x[boss] > entities.x[player] - 1 && grounded && entities.y[player] > entities.y[boss]+1.5f) {
+				if (entities.x[boss] > 7.5f) entities.velocityX[boss] = -8.0f;
+				else entities.velocityX[boss] = 8.0f;
+			}
+			if (gameRandom() % 100 == 1 && entities.y[boss] < 2.0f && (grounded || health < 3)) entities.velocityY[boss] = 4.0f + (5-health)/2;
+			if (bossDetail.frame == 0 && bossDetail.lastFrame + 0.9f < ticks && grounded) {
+				bossDetail.frame++;
+				bossDetail.sprite = bossDetail.frames[bossDetail.frame];
+				bossDetail.lastFrame = ticks;
+			}
+			else if (bossDetail.frame == 1 && bossDetail.lastFrame + 0.9f < ticks && grounded) {
+				bossDetail.frame--;
+				bossDetail.sprite = bossDetail.frames[bossDetail.frame];
+				bossDetail.lastFrame = ticks;
+			}
+		}
+		// Everything moves first, nothing below feeds back into another entity's motion this step:
+		// a collision only touches the entity itself and the player, which has already had its turn
+		IntegrateBodies(entities, elapsed);
+		// All Collision Checking
+		PROFILE_SCOPE("Collision");
+		for (size_t ent = 0; ent < entities.Size(); ++ent) {
+			if (entities.alive[ent]) {
+				if (entities.type[ent] == EntityStore::ENTITY_FLY) {
+					entities.y[ent] += sin(ticks)*elapsed;
+					EntityDetail& fly = entities.detail[ent];
+					if(fly.frame == 0 && fly.lastFrame + 1.0f < ticks) {
+						fly.frame++;
+						fly.sprite = fly.frames[fly.frame];
+						fly.lastFrame = ticks;
+					}
+					else if(fly.frame == 1 && fly.lastFrame + 1.0f < ticks){
+						fly.frame--;
+						fly.sprite = fly.frames[fly.frame];
+						fly.lastFrame = ticks;
+					}
+				}
+				resolveTileCollisions(state, ent, entities.previousX[ent]);
+
+				const size_t player = 0;
+				if (ent != player && isCollidingRect(entities, player, ent)) {
+					if (entities.y[player] - (entities.height[player] / 2) >= entities.y[ent] + (entities.height[ent] / 2) - 0.2f) {
+						entities.Hit(ent);
+						entities.velocityY[player] = 6;
+					}
+					else {
+						entities.Hit(player);
+					}
+
+					audio.Play(SOUND_KILL);
+				}
+			}
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void Step(const InputState& input, unsigned long stepIndex, bool& done, GameState*& currentState, StateLoader& states, AudioSink& audio) {
+	ProcessInput(input, done, currentState, states, audio);
+	Update(currentState, FIXED_TIMESTEP, stepIndex * FIXED_TIMESTEP, audio);
+}
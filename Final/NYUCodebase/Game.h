@@ -0,0 +1,256 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <map>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include "TileLayer.h"
+#include "TileProperties.h"
+
+// 60 FPS (1.0f/60.0f) (update sixty times a second)
+#define FIXED_TIMESTEP 0.0166666f
+// Downward acceleration of everything but flies, in world units per second squared
+#define GRAVITY -6.0f
+
+// Everything the game needs to simulate a level, with no SDL or OpenGL in it so it can run
+// headless as well as behind the SDL front end in main.cpp
+
+// SpriteSheet
+class SheetSprite {
+public:
+	SheetSprite() {};
+	SheetSprite(unsigned int textureID, std::array<float, 4> coords, float size) :
+		textureID(textureID), u(coords[0]), v(coords[1]), width(coords[2]), height(coords[3]), size(size) {};
+	SheetSprite(unsigned int textureID, float u, float v, float width, float height, float size) : 
+		textureID(textureID), u(u), v(v), width(width), height(height), size(size) {}
+	unsigned int textureID;
+	float u;
+	float v;
+	float width;
+	float height;
+	float size;
+};
+
+// 3D Vector
+class Vector {
+public:
+	constexpr Vector() : x(0.0f), y(0.0f), z(0.0f), b(1.0f) {}
+	constexpr Vector(const float x, const float y, const float z) : x(x), y(y), z(z), b(1.0f) {}
+	constexpr Vector(const float x, const float y, const float z, const float b) : x(x), y(y), z(z), b(b) {}
+	constexpr Vector& operator=(Vector const& rhs) {
+		x = rhs.x;
+		y = rhs.y;
+		z = rhs.z;
+		b = rhs.b;
+		return *this;
+	}
+	constexpr Vector operator+(Vector const& rhs) const {
+		Vector out(x + rhs.x, y + rhs.y, z + rhs.z, b + rhs.b);
+		return out;
+	}
+	constexpr Vector& operator+=(Vector const& rhs) {
+		x += rhs.x;
+		y += rhs.y;
+		z += rhs.z;
+		b += rhs.b;
+		return *this;
+	}
+	constexpr Vector operator*(const float num) const {
+		Vector out(x*num, y*num, z*num, b*num);
+		return out;
+	}
+	constexpr Vector& operator*=(const float num) {
+		x *= num;
+		y *= num;
+		z *= num;
+		b *= num;
+		return *this;
+	}
+	float length() const {
+		return sqrt(x*x + y*y + z*z);
+	}
+	Vector normalize() const {
+		const float length = this->length();
+		if(length) {
+			return Vector(x / length, y / length, z / length, b);
+		}
+		return Vector();
+	}
+	float x, y, z, b;
+};
+
+// Names an entity of a store. Still safe to hold after the entity is destroyed: its slot gets a
+// new generation when freed, so Valid() turns false instead of the handle finding a stranger.
+struct EntityHandle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+// The parts of an entity only hits, animation and drawing read
+struct EntityDetail {
+	SheetSprite sprite;
+	std::vector<SheetSprite> frames;
+	int health = 1;
+	int frame = 0;
+	int lastFrame = 0;
+};
+
+// Every entity of a level as parallel arrays, element i of each belonging to entity i, so a pass
+// over positions streams through positions alone. Entities keep their index for as long as they
+// live and a destroyed one's slot goes to the next Create, so the arrays never shift.
+class EntityStore {
+public:
+	enum ENTITY_TYPE { ENTITY_PLAYER, ENTITY_SNAIL, ENTITY_FLY, ENTITY_BOSS };
+	/*
+	 *  contact bits clockwise:
+	 *		  top
+	 *	left  obj  right
+	 *		 bottom
+	 */
+	enum CONTACT { CONTACT_TOP = 1, CONTACT_RIGHT = 2, CONTACT_BOTTOM = 4, CONTACT_LEFT = 8 };
+
+	EntityHandle Create(ENTITY_TYPE type, const SheetSprite& sprite, float x, float y);
+	void Destroy(EntityHandle handle);
+	bool Valid(EntityHandle handle) const;
+	EntityHandle Handle(size_t index) const { return { (uint32_t)index, generation[index] }; }
+	// false for a slot freed by Destroy and not reused yet
+	bool InUse(size_t index) const { return used[index] != 0; }
+	// Slots, including freed ones
+	size_t Size() const { return x.size(); }
+	void Reserve(size_t count);
+
+	void Hit(size_t index) {
+		if (--detail[index].health == 0) alive[index] = false;
+	}
+	// Position blended between the last two simulation steps
+	Vector Interpolated(size_t index, float alpha) const {
+		return Vector(previousX[index] + (x[index] - previousX[index]) * alpha,
+			previousY[index] + (y[index] - previousY[index]) * alpha, 0.0f);
+	}
+
+	// read or written by every step
+	std::vector<float> x;
+	std::vector<float> y;
+	// position at the start of the current simulation step
+	std::vector<float> previousX;
+	std::vector<float> previousY;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> width;
+	std::vector<float> height;
+	std::vector<uint8_t> type;
+	std::vector<uint8_t> alive;
+	// CONTACT bits from the last tile collision pass
+	std::vector<uint8_t> contact;
+	// everything else
+	std::vector<EntityDetail> detail;
+
+private:
+	std::vector<uint32_t> generation;
+	std::vector<uint8_t> used;
+	std::vector<uint32_t> freeSlots;
+};
+
+// Sounds the simulation asks for, the front end decides what actually plays
+enum GAME_SOUND { SOUND_JUMP, SOUND_KILL, SOUND_COUNT };
+
+// Where the simulation sends its sounds, this base class drops them
+class AudioSink {
+public:
+	virtual ~AudioSink() {}
+	virtual void Play(GAME_SOUND sound) {}
+};
+
+// One frame of player input, filled from SDL events or read from a script
+struct InputState {
+	// window closed or escape pressed
+	bool quit = false;
+	// any key went down this frame
+	bool keyPressed = false;
+	// space went down this frame
+	bool jump = false;
+	// arrow keys held
+	bool left = false;
+	bool right = false;
+
+	// Folds in a later frame's input, presses stay until a step consumes them
+	void Merge(const InputState& next) {
+		quit = quit || next.quit;
+		keyPressed = keyPressed || next.keyPressed;
+		jump = jump || next.jump;
+		left = next.left;
+		right = next.right;
+	}
+	void ClearPresses() {
+		quit = false;
+		keyPressed = false;
+		jump = false;
+	}
+};
+
+// Render side of a level, only the SDL build creates one
+class TileMesh;
+class StateLoader;
+
+// Game States
+class GameState {
+public:
+	enum STATE_TYPE { STATE_MENU, STATE_GAME, STATE_WIN, STATE_LOSE };
+	GameState(STATE_TYPE type) : tileProperties(nullptr), tileMesh(nullptr), tileTexture(0), type(type) {}
+	EntityStore entities;
+	TileLayer tiles;
+	// tile layers after the first, drawn over it in order but never collided with
+	std::vector<TileLayer> overlayLayers;
+	// shared by every level drawn from the same tileset
+	const TileProperties* tileProperties;
+	TileMesh* tileMesh;
+	unsigned int tileTexture;
+	STATE_TYPE type;
+	std::map<int, SheetSprite> sprites;
+};
+
+// Seeds the game's own random generator, the same seed and input replay the same game
+void SeedRandom(uint32_t seed);
+
+float randf(float a, float b);
+
+float lerp(float v0, float v1, float t);
+
+// Where a sprite sits on its sheet as u, v, width and height, usable in constant expressions
+constexpr std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height) {
+	return { { float(xPx) / sheetWidth, float(yPx) / sheetHeight, float(width) / sheetWidth, float(height) / sheetHeight } };
+}
+
+bool isCollidingRect(const EntityStore& entities, size_t r1, size_t r2);
+
+int tileColumn(float worldX);
+
+int tileRow(float worldY);
+
+void resolveTileCollisions(GameState* state, size_t ent, float previousX);
+
+bool parseEntityType(const std::string& name, EntityStore::ENTITY_TYPE& type);
+
+void placeEntity(std::string type, GameState* state, float placeX, float placeY);
+
+void placeEntity(EntityStore::ENTITY_TYPE entityType, GameState* state, float placeX, float placeY);
+
+// Loads a compiled .lvl, a Tiled .tmx or a Flare text export, by extension
+bool LoadLevel(const std::string& levelFile, GameState* state);
+
+// Sprites for each entity type of a game level, set before the level's entities are placed
+void AssignLevelSprites(GameState* state);
+
+// Animation frames of the placed player and enemies
+void AssignEntityFrames(GameState* state);
+
+void ProcessInput(const InputState& input, bool& done, GameState*& currentState, StateLoader& states, AudioSink& audio);
+
+void Update(GameState* state, float elapsed, float ticks, AudioSink& audio);
+
+// Runs fixed step number stepIndex, input first, with the game clock derived from the step count.
+// Every loop that advances the game goes through here so a recording plays back identically.
+void Step(const InputState& input, unsigned long stepIndex, bool& done, GameState*& currentState, StateLoader& states, AudioSink& audio);
@@ -0,0 +1,157 @@
+// Headless runner for the Platformer Demo
+// Steps the simulation with no window, GL context or audio device, as fast as the CPU allows,
+// reading the player's input from a script or a recording made with the game's -record flag.
+// Built on Linux with the Makefile next to it.
+//
+// usage: headless [script] [steps] [state]
+//   script  input script or recording, see InputScript.h, idle input when left out
+//   steps   steps to run, defaults to the length of the script (or a minute of game time)
+//   state   index in States.txt to start in rather than the menu, to replay one level on its own
+//        headless --verify [bodies]
+//   runs the vector and scalar integrators over the same random bodies and fails if any bit
+//   differs, timing both
+//
+// The checksum printed at the end covers every entity of every state the run loaded, two runs of
+// the same recording that print the same checksum simulated the same game.
+
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "Game.h"
+#include "InputScript.h"
+#include "Integrator.h"
+#include "Profiler.h"
+#include "StateLoader.h"
+
+// FNV-1a over the bits of every entity's position, velocity and health
+uint32_t Checksum(const StateLoader& states) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < states.Count(); ++i) {
+		const GameState* state = states.Get(i);
+		if (state == nullptr) continue;
+		const EntityStore& entities = state->entities;
+		for (size_t ent = 0; ent < entities.Size(); ++ent) {
+			if (!entities.InUse(ent)) continue;
+			float values[5] = { entities.x[ent], entities.y[ent], entities.velocityX[ent], entities.velocityY[ent], (float)entities.detail[ent].health };
+			unsigned char bytes[sizeof(values)];
+			memcpy(bytes, values, sizeof(values));
+			for (unsigned char byte : bytes) {
+				hash = (hash ^ byte) * 16777619u;
+			}
+		}
+	}
+	return hash;
+}
+
+// Name of the first of x, y, velocityX or velocityY where a and b differ, null if none does
+static const char* firstDifference(const EntityStore& a, const EntityStore& b, size_t& index) {
+	const std::vector<float>* arraysA[4] = { &a.x, &a.y, &a.velocityX, &a.velocityY };
+	const std::vector<float>* arraysB[4] = { &b.x, &b.y, &b.velocityX, &b.velocityY };
+	const char* names[4] = { "x", "y", "velocityX", "velocityY" };
+	for (index = 0; index < a.Size(); ++index) {
+		for (int i = 0; i < 4; ++i) {
+			if (memcmp(&(*arraysA[i])[index], &(*arraysB[i])[index], sizeof(float)) != 0) return names[i];
+		}
+	}
+	return nullptr;
+}
+
+int VerifyIntegrator(size_t bodies) {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> speed(-10.0f, 10.0f);
+	EntityStore vector;
+	vector.Reserve(bodies);
+	for (size_t i = 0; i < bodies; ++i) {
+		vector.Create((EntityStore::ENTITY_TYPE)(random() % 4), SheetSprite(), position(random), position(random));
+		vector.velocityX[i] = speed(random);
+		vector.velocityY[i] = speed(random);
+		if (random() % 8 == 0) vector.alive[i] = false;
+	}
+	// every pairing of the values rounding is most likely to trip over, kept to the first hundred
+	// bodies since subnormals would slow both sides down enough to swamp the timing
+	const float awkward[] = { 0.0f, -0.0f, FLT_MIN, -FLT_MIN, FLT_MIN / 4, -FLT_MIN / 4, FLT_MAX, -FLT_MAX, 1e-30f, -1e30f };
+	for (size_t i = 0; i < bodies && i < 100; ++i) {
+		vector.velocityX[i] = awkward[i % 10];
+		vector.velocityY[i] = awkward[i / 10];
+	}
+	EntityStore scalar = vector;
+
+	const int steps = 600;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int step = 0; step < steps; ++step) {
+		IntegrateBodies(vector, FIXED_TIMESTEP * (1 + step % 3));
+	}
+	double vectorSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	start = std::chrono::steady_clock::now();
+	for (int step = 0; step < steps; ++step) {
+		IntegrateBodiesScalar(scalar, 0, scalar.Size(), FIXED_TIMESTEP * (1 + step % 3));
+	}
+	double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Integrator: " << IntegratorKernel() << ", " << bodies << " bodies for " << steps << " steps, "
+		<< vectorSeconds * 1000.0 << " ms against " << scalarSeconds * 1000.0 << " ms scalar ("
+		<< (vectorSeconds > 0.0 ? scalarSeconds / vectorSeconds : 0.0) << "x)" << std::endl;
+	size_t index;
+	const char* field = firstDifference(vector, scalar, index);
+	if (field) {
+		std::cout << "Mismatch: body " << index << " " << field << std::endl;
+		return 1;
+	}
+	std::cout << "Identical" << std::endl;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "--verify") == 0) {
+		return VerifyIntegrator(argc > 2 ? strtoul(argv[2], NULL, 10) : 50000);
+	}
+	InputScript script;
+	if (argc > 1 && !script.Load(argv[1])) {
+		return 1;
+	}
+	unsigned long steps = script.Length();
+	if (argc > 2) steps = strtoul(argv[2], NULL, 10);
+	if (steps == 0) steps = (unsigned long)(60.0f / FIXED_TIMESTEP);
+	size_t first = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+
+	// Sounds go nowhere
+	AudioSink audio;
+	SeedRandom(script.seed);
+	// No window to draw in, every texture is 0
+	StateResources resources;
+	StateLoader states(resources);
+	if (!states.LoadManifest("States.txt")) {
+		return 1;
+	}
+	if (first >= states.Count()) {
+		std::cout << "No state " << first << " in States.txt" << std::endl;
+		return 1;
+	}
+	GameState* currentState = states.Enter(first);
+	if (currentState == nullptr) {
+		return 1;
+	}
+
+	bool done = false;
+	unsigned long step = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (; step < steps && !done; ++step) {
+		Step(script.Next(), step, done, currentState, states, audio);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Steps: " << step << " in " << seconds << "s (" << (seconds > 0.0 ? step / seconds : 0.0) << " steps/s)" << std::endl;
+	std::cout << "State: " << states.Current() << std::endl;
+	const EntityStore& entities = currentState->entities;
+	if (entities.Size() > 0) {
+		std::cout << "Player: " << entities.x[0] << ", " << entities.y[0] << (entities.alive[0] ? "" : " (dead)") << std::endl;
+	}
+	std::cout << "Checksum: " << std::hex << Checksum(states) << std::dec << std::endl;
+	PROFILE_WRITE("trace.json");
+	return 0;
+}
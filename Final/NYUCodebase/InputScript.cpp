@@ -0,0 +1,166 @@
+#include "InputScript.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// Recording layout, little endian: "FINP", version, seed, span count, then per span a key byte
+// and a 32 bit step count
+#define RECORDING_MAGIC "FINP"
+#define RECORDING_VERSION 1
+
+enum INPUT_KEY : uint8_t { KEY_QUIT = 1 << 0, KEY_PRESSED = 1 << 1, KEY_JUMP = 1 << 2, KEY_LEFT = 1 << 3, KEY_RIGHT = 1 << 4 };
+
+static uint8_t packKeys(const InputState& input) {
+	return (input.quit ? KEY_QUIT : 0) | (input.keyPressed ? KEY_PRESSED : 0) | (input.jump ? KEY_JUMP : 0) |
+		(input.left ? KEY_LEFT : 0) | (input.right ? KEY_RIGHT : 0);
+}
+
+static InputState unpackKeys(uint8_t keys) {
+	InputState input;
+	input.quit = (keys & KEY_QUIT) != 0;
+	input.keyPressed = (keys & KEY_PRESSED) != 0;
+	input.jump = (keys & KEY_JUMP) != 0;
+	input.left = (keys & KEY_LEFT) != 0;
+	input.right = (keys & KEY_RIGHT) != 0;
+	return input;
+}
+
+static void writeUint32(std::ofstream& stream, uint32_t value) {
+	char bytes[4] = { (char)(value & 0xff), (char)((value >> 8) & 0xff), (char)((value >> 16) & 0xff), (char)(value >> 24) };
+	stream.write(bytes, 4);
+}
+
+static bool readUint32(std::ifstream& stream, uint32_t& value) {
+	unsigned char bytes[4];
+	if (!stream.read((char*)bytes, 4)) return false;
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	return true;
+}
+
+bool InputScript::Load(const std::string& scriptFile) {
+	std::ifstream infile(scriptFile, std::ios::binary);
+	if (!infile) {
+		std::cout << "Unable to open input script " << scriptFile << std::endl;
+		return false;
+	}
+	seed = 0;
+	spans.clear();
+	span = 0;
+	spanStep = 0;
+	char magic[4] = {};
+	infile.read(magic, 4);
+	if (infile && std::string(magic, 4) == RECORDING_MAGIC) {
+		return LoadRecording(infile, scriptFile);
+	}
+	infile.clear();
+	infile.seekg(0);
+	return LoadText(infile, scriptFile);
+}
+
+bool InputScript::LoadText(std::ifstream& infile, const std::string& scriptFile) {
+	std::string line;
+	int lineNumber = 0;
+	while (getline(infile, line)) {
+		++lineNumber;
+		line = line.substr(0, line.find('#'));
+		std::istringstream sStream(line);
+		if (line.compare(0, 4, "seed") == 0) {
+			std::string key;
+			sStream >> key >> seed;
+			continue;
+		}
+		Span next;
+		std::string keys = "-";
+		if (!(sStream >> next.steps)) {
+			// blank or comment
+			continue;
+		}
+		sStream >> keys;
+		for (char key : keys) {
+			switch (key) {
+			case 'L': next.input.left = true; break;
+			case 'R': next.input.right = true; break;
+			case 'J': next.input.jump = true; next.input.keyPressed = true; break;
+			case 'K': next.input.keyPressed = true; break;
+			case 'Q': next.input.quit = true; break;
+			case '-': break;
+			default:
+				std::cout << scriptFile << ":" << lineNumber << ": unknown key '" << key << "'" << std::endl;
+				return false;
+			}
+		}
+		if (next.steps > 0) spans.push_back(next);
+	}
+	return true;
+}
+
+bool InputScript::LoadRecording(std::ifstream& infile, const std::string& recordingFile) {
+	uint32_t version, count;
+	if (!readUint32(infile, version) || version != RECORDING_VERSION || !readUint32(infile, seed) || !readUint32(infile, count)) {
+		std::cout << recordingFile << ": unsupported or damaged recording" << std::endl;
+		return false;
+	}
+	spans.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		char keys;
+		Span next;
+		if (!infile.get(keys) || !readUint32(infile, next.steps)) {
+			std::cout << recordingFile << ": recording ends after " << i << " of " << count << " spans" << std::endl;
+			return false;
+		}
+		next.input = unpackKeys((uint8_t)keys);
+		spans.push_back(next);
+	}
+	return true;
+}
+
+bool InputScript::Save(const std::string& recordingFile) const {
+	std::ofstream outfile(recordingFile, std::ios::binary);
+	if (!outfile) {
+		std::cout << "Unable to write recording " << recordingFile << std::endl;
+		return false;
+	}
+	outfile.write(RECORDING_MAGIC, 4);
+	writeUint32(outfile, RECORDING_VERSION);
+	writeUint32(outfile, seed);
+	writeUint32(outfile, (uint32_t)spans.size());
+	for (const Span& next : spans) {
+		outfile.put((char)packKeys(next.input));
+		writeUint32(outfile, next.steps);
+	}
+	return (bool)outfile;
+}
+
+void InputScript::Record(const InputState& input) {
+	// presses only land on a span's first step, so a step without any continues the last span
+	// as long as the held keys match
+	bool pressed = input.quit || input.keyPressed || input.jump;
+	if (!spans.empty() && !pressed && spans.back().input.left == input.left && spans.back().input.right == input.right && spans.back().steps < UINT32_MAX) {
+		++spans.back().steps;
+		return;
+	}
+	Span next;
+	next.steps = 1;
+	next.input = input;
+	spans.push_back(next);
+}
+
+InputState InputScript::Next() {
+	if (Finished()) return InputState();
+	InputState input = spans[span].input;
+	if (spanStep > 0) {
+		// presses only land on the first step of a span
+		input.ClearPresses();
+	}
+	if (++spanStep >= spans[span].steps) {
+		++span;
+		spanStep = 0;
+	}
+	return input;
+}
+
+unsigned long InputScript::Length() const {
+	unsigned long steps = 0;
+	for (const Span& next : spans) steps += next.steps;
+	return steps;
+}
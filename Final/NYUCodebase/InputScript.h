@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Game.h"
+
+// A stream of per-step input plus the random seed, for driving the simulation without a keyboard
+// and for replaying a recorded session exactly. Scripts are written by hand as text, one span
+// per line with a step count and the keys for that span:
+//
+//     seed 1234
+//     # steps keys
+//     1 K      any key, leaves the menu
+//     60 R     hold right for a second
+//     1 RJ     jump while still holding right
+//     30 -     nothing
+//
+// L and R are held for the whole span, J (space), K (any other key) and Q (quit) fire on its
+// first step only. Past the end of the stream every step is idle.
+//
+// Recordings hold the same spans in a compact binary file, see Save().
+class InputScript {
+public:
+	InputScript() : seed(0), span(0), spanStep(0) {}
+
+	// Reads a recording or a text script, whichever the file is
+	bool Load(const std::string& scriptFile);
+	// Writes the spans as a recording
+	bool Save(const std::string& recordingFile) const;
+
+	// Appends the input of the next step, extending the last span when nothing changed
+	void Record(const InputState& input);
+
+	// Input for the next step
+	InputState Next();
+	bool Finished() const { return span >= spans.size(); }
+	// Steps the whole stream covers
+	unsigned long Length() const;
+
+	struct Span {
+		uint32_t steps;
+		InputState input;
+	};
+	uint32_t seed;
+	std::vector<Span> spans;
+
+private:
+	bool LoadText(std::ifstream& infile, const std::string& scriptFile);
+	bool LoadRecording(std::ifstream& infile, const std::string& recordingFile);
+
+	size_t span;
+	uint32_t spanStep;
+};
@@ -0,0 +1,145 @@
+#include "Integrator.h"
+#include "Profiler.h"
+#include <cstring>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define INTEGRATOR_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define INTEGRATOR_LANES 4
+#else
+	#define INTEGRATOR_LANES 1
+#endif
+
+void IntegrateBodiesScalar(EntityStore& entities, size_t begin, size_t end, float elapsed) {
+	for (size_t i = begin; i < end; ++i) {
+		if (!entities.alive[i] || entities.type[i] == EntityStore::ENTITY_FLY) continue;
+		if (entities.type[i] != EntityStore::ENTITY_BOSS) entities.velocityX[i] = lerp(entities.velocityX[i], 0.0f, elapsed);
+		entities.x[i] += entities.velocityX[i] * elapsed;
+		entities.y[i] += entities.velocityY[i] * elapsed;
+		entities.velocityY[i] += GRAVITY * elapsed;
+	}
+}
+
+#if INTEGRATOR_LANES > 1
+// Four entries of a byte array, one per 32 bit lane
+static inline __m128i loadBytes(const uint8_t* bytes) {
+	int packed;
+	memcpy(&packed, bytes, sizeof(packed));
+	const __m128i zero = _mm_setzero_si128();
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+}
+
+// All ones in the lanes of entities i to i + 3 that move at all, and in those that also get friction
+static inline void laneMasks(const EntityStore& entities, size_t i, __m128& moving, __m128& friction) {
+	__m128i alive = loadBytes(&entities.alive[i]);
+	__m128i type = loadBytes(&entities.type[i]);
+	__m128i live = _mm_cmpgt_epi32(alive, _mm_setzero_si128());
+	__m128i fly = _mm_cmpeq_epi32(type, _mm_set1_epi32(EntityStore::ENTITY_FLY));
+	__m128i boss = _mm_cmpeq_epi32(type, _mm_set1_epi32(EntityStore::ENTITY_BOSS));
+	__m128i movingBits = _mm_andnot_si128(fly, live);
+	moving = _mm_castsi128_ps(movingBits);
+	friction = _mm_castsi128_ps(_mm_andnot_si128(boss, movingBits));
+}
+
+static inline __m128 select4(__m128 mask, __m128 chosen, __m128 otherwise) {
+	return _mm_or_ps(_mm_and_ps(mask, chosen), _mm_andnot_ps(mask, otherwise));
+}
+
+// lerp(velocity, 0.0f, t) on four lanes. lerp works in double, (1.0 - t) * v + t * 0, then rounds
+// back to float, so this does the same; adding the zero is what turns a -0 into +0 there.
+static inline __m128 friction4(__m128 velocity, __m128d keep) {
+	const __m128d zero = _mm_setzero_pd();
+	__m128d low = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(velocity), keep), zero);
+	__m128d high = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(velocity, velocity)), keep), zero);
+	return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+}
+
+// Whole groups of four from begin on, returns where the next entity the group didn't cover starts
+static size_t integrateSse2(EntityStore& entities, size_t begin, size_t end, float elapsed) {
+	const __m128 step = _mm_set1_ps(elapsed);
+	const __m128 fall = _mm_set1_ps(GRAVITY * elapsed);
+	const __m128d keep = _mm_set1_pd(1.0 - elapsed);
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 moving, friction;
+		laneMasks(entities, i, moving, friction);
+		__m128 x = _mm_loadu_ps(&entities.x[i]);
+		__m128 y = _mm_loadu_ps(&entities.y[i]);
+		__m128 velocityX = _mm_loadu_ps(&entities.velocityX[i]);
+		__m128 velocityY = _mm_loadu_ps(&entities.velocityY[i]);
+		velocityX = select4(friction, friction4(velocityX, keep), velocityX);
+		_mm_storeu_ps(&entities.x[i], select4(moving, _mm_add_ps(x, _mm_mul_ps(velocityX, step)), x));
+		_mm_storeu_ps(&entities.y[i], select4(moving, _mm_add_ps(y, _mm_mul_ps(velocityY, step)), y));
+		_mm_storeu_ps(&entities.velocityX[i], velocityX);
+		_mm_storeu_ps(&entities.velocityY[i], select4(moving, _mm_add_ps(velocityY, fall), velocityY));
+	}
+	return i;
+}
+#endif
+
+#if INTEGRATOR_LANES == 8
+// All ones in the lanes of entities i to i + 7 that move at all, and in those that also get friction
+static inline void laneMasks8(const EntityStore& entities, size_t i, __m256& moving, __m256& friction) {
+	__m256i alive = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&entities.alive[i])));
+	__m256i type = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&entities.type[i])));
+	__m256i live = _mm256_cmpgt_epi32(alive, _mm256_setzero_si256());
+	__m256i fly = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(EntityStore::ENTITY_FLY));
+	__m256i boss = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(EntityStore::ENTITY_BOSS));
+	__m256i movingBits = _mm256_andnot_si256(fly, live);
+	moving = _mm256_castsi256_ps(movingBits);
+	friction = _mm256_castsi256_ps(_mm256_andnot_si256(boss, movingBits));
+}
+
+static inline __m256 friction8(__m256 velocity, __m256d keep) {
+	const __m256d zero = _mm256_setzero_pd();
+	__m256d low = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(velocity)), keep), zero);
+	__m256d high = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(velocity, 1)), keep), zero);
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low)), _mm256_cvtpd_ps(high), 1);
+}
+
+static size_t integrateAvx(EntityStore& entities, size_t begin, size_t end, float elapsed) {
+	const __m256 step = _mm256_set1_ps(elapsed);
+	const __m256 fall = _mm256_set1_ps(GRAVITY * elapsed);
+	const __m256d keep = _mm256_set1_pd(1.0 - elapsed);
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 moving, friction;
+		laneMasks8(entities, i, moving, friction);
+		__m256 x = _mm256_loadu_ps(&entities.x[i]);
+		__m256 y = _mm256_loadu_ps(&entities.y[i]);
+		__m256 velocityX = _mm256_loadu_ps(&entities.velocityX[i]);
+		__m256 velocityY = _mm256_loadu_ps(&entities.velocityY[i]);
+		velocityX = _mm256_blendv_ps(velocityX, friction8(velocityX, keep), friction);
+		_mm256_storeu_ps(&entities.x[i], _mm256_blendv_ps(x, _mm256_add_ps(x, _mm256_mul_ps(velocityX, step)), moving));
+		_mm256_storeu_ps(&entities.y[i], _mm256_blendv_ps(y, _mm256_add_ps(y, _mm256_mul_ps(velocityY, step)), moving));
+		_mm256_storeu_ps(&entities.velocityX[i], velocityX);
+		_mm256_storeu_ps(&entities.velocityY[i], _mm256_blendv_ps(velocityY, _mm256_add_ps(velocityY, fall), moving));
+	}
+	return i;
+}
+#endif
+
+void IntegrateBodies(EntityStore& entities, float elapsed) {
+	PROFILE_SCOPE("IntegrateBodies");
+	size_t count = entities.Size();
+	size_t done = 0;
+#if INTEGRATOR_LANES == 8
+	done = integrateAvx(entities, done, count, elapsed);
+#endif
+#if INTEGRATOR_LANES > 1
+	done = integrateSse2(entities, done, count, elapsed);
+#endif
+	IntegrateBodiesScalar(entities, done, count, elapsed);
+}
+
+const char* IntegratorKernel() {
+#if INTEGRATOR_LANES == 8
+	return "AVX2";
+#elif INTEGRATOR_LANES == 4
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
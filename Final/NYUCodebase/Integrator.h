@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Game.h"
+
+// Moves every live entity of a store one step: friction on x for everything but the boss, then
+// position from velocity, then gravity on y. Flies are left alone, they bob on their own.
+//
+// Runs AVX2 or SSE2 lanes over the store's arrays when the build targets them and the scalar loop
+// for the rest. Both give the same bits as each other and as the scalar code the game always ran,
+// `headless --verify` checks that.
+void IntegrateBodies(EntityStore& entities, float elapsed);
+
+// The same step one entity at a time, what IntegrateBodies falls back to
+void IntegrateBodiesScalar(EntityStore& entities, size_t begin, size_t end, float elapsed);
+
+// "AVX2", "SSE2" or "scalar", whichever IntegrateBodies was built with
+const char* IntegratorKernel();
@@ -0,0 +1,28 @@
+// levelc, compiles Tiled .tmx maps or Flare text level exports into the binary format in LevelFile.h
+//
+// usage: levelc input.tmx|input.txt output.lvl
+//
+// Run it again after editing a level, `make levels` rebuilds every out of date .lvl here.
+
+#include <iostream>
+#include "Game.h"
+#include "LevelFile.h"
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3) {
+		std::cout << "usage: levelc input.tmx|input.txt output.lvl" << std::endl;
+		return 1;
+	}
+	GameState state(GameState::STATE_GAME);
+	if (!LoadLevel(argv[1], &state)) {
+		std::cout << "Unable to read level " << argv[1] << std::endl;
+		return 1;
+	}
+	if (!SaveCompiledLevel(argv[2], &state)) {
+		return 1;
+	}
+	std::cout << argv[1] << " -> " << argv[2] << ": " << state.tiles.Width() << "x" << state.tiles.Height() << " tiles in " << 1 + state.overlayLayers.size() << " layers, "
+		<< state.entities.Size() << " objects" << std::endl;
+	return 0;
+}
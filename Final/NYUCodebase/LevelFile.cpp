@@ -0,0 +1,98 @@
+#include "LevelFile.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+bool LoadCompiledLevel(const std::string& levelFile, GameState* state) {
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->Open(levelFile)) {
+		return false;
+	}
+	LevelFileHeader header;
+	if (file->Size() < sizeof(header)) {
+		std::cout << levelFile << ": too small to be a compiled level" << std::endl;
+		return false;
+	}
+	memcpy(&header, file->Data(), sizeof(header));
+	if (memcmp(header.magic, LEVEL_FILE_MAGIC, 4) != 0 || header.version != LEVEL_FILE_VERSION) {
+		std::cout << levelFile << ": not a version " << LEVEL_FILE_VERSION << " compiled level" << std::endl;
+		return false;
+	}
+	const uint64_t layerTiles = (uint64_t)header.width * header.height;
+	uint64_t tilesEnd = header.tilesOffset + layerTiles * header.layerCount * sizeof(uint16_t);
+	uint64_t objectsEnd = header.objectsOffset + (uint64_t)header.objectCount * sizeof(LevelObject);
+	if (header.layerCount == 0 || layerTiles > file->Size() || header.tilesOffset % sizeof(uint16_t) != 0 || tilesEnd > file->Size() || objectsEnd > file->Size() ||
+		header.width > INT32_MAX || header.height > INT32_MAX) {
+		std::cout << levelFile << ": header points outside the file" << std::endl;
+		return false;
+	}
+
+	const unsigned char* objects = file->Data() + header.objectsOffset;
+	std::vector<LevelObject> placed(header.objectCount);
+	for (uint32_t i = 0; i < header.objectCount; ++i) {
+		memcpy(&placed[i], objects + i * sizeof(LevelObject), sizeof(LevelObject));
+		if (placed[i].type > EntityStore::ENTITY_BOSS) {
+			std::cout << levelFile << ": object " << i << " has unknown type " << placed[i].type << std::endl;
+			return false;
+		}
+	}
+
+	// the tiles are used where they sit in the mapping, no copy
+	const uint16_t* tiles = (const uint16_t*)(file->Data() + header.tilesOffset);
+	state->tiles.Map(file, tiles, (int)header.width, (int)header.height);
+	state->overlayLayers.resize(header.layerCount - 1);
+	for (uint32_t i = 1; i < header.layerCount; ++i) {
+		state->overlayLayers[i - 1].Map(file, tiles + layerTiles * i, (int)header.width, (int)header.height);
+	}
+	state->entities.Reserve(placed.size());
+	for (const LevelObject& object : placed) {
+		placeEntity((EntityStore::ENTITY_TYPE)object.type, state, object.x, object.y);
+	}
+	return true;
+}
+
+bool SaveCompiledLevel(const std::string& levelFile, const GameState* state) {
+	for (const TileLayer& overlay : state->overlayLayers) {
+		if (overlay.Width() != state->tiles.Width() || overlay.Height() != state->tiles.Height()) {
+			std::cout << levelFile << ": every layer of a compiled level must be " << state->tiles.Width() << "x" << state->tiles.Height() << std::endl;
+			return false;
+		}
+	}
+	std::ofstream outfile(levelFile, std::ios::binary);
+	if (!outfile) {
+		std::cout << "Unable to write " << levelFile << std::endl;
+		return false;
+	}
+	LevelFileHeader header;
+	memcpy(header.magic, LEVEL_FILE_MAGIC, 4);
+	header.version = LEVEL_FILE_VERSION;
+	header.width = (uint32_t)state->tiles.Width();
+	header.height = (uint32_t)state->tiles.Height();
+	header.layerCount = (uint32_t)(1 + state->overlayLayers.size());
+	header.tilesOffset = sizeof(LevelFileHeader);
+	const size_t tileBytes = header.layerCount * state->tiles.Size() * sizeof(uint16_t);
+	const EntityStore& entities = state->entities;
+	uint32_t objectCount = 0;
+	for (size_t i = 0; i < entities.Size(); ++i) {
+		if (entities.InUse(i)) ++objectCount;
+	}
+	header.objectCount = objectCount;
+	// objects start on a 4 byte boundary after the tiles
+	header.objectsOffset = (uint32_t)((header.tilesOffset + tileBytes + 3) & ~(size_t)3);
+	outfile.write((const char*)&header, sizeof(header));
+	outfile.write((const char*)state->tiles.Data(), state->tiles.Size() * sizeof(uint16_t));
+	for (const TileLayer& overlay : state->overlayLayers) {
+		outfile.write((const char*)overlay.Data(), overlay.Size() * sizeof(uint16_t));
+	}
+	const char padding[4] = {};
+	outfile.write(padding, header.objectsOffset - (header.tilesOffset + tileBytes));
+	for (size_t i = 0; i < entities.Size(); ++i) {
+		if (!entities.InUse(i)) continue;
+		LevelObject object = { entities.type[i], entities.x[i], entities.y[i] };
+		outfile.write((const char*)&object, sizeof(object));
+	}
+	return (bool)outfile;
+}
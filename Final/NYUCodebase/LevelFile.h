@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Game.h"
+
+// Compiled level, written offline by levelc from a Tiled .tmx map or a Flare text export and
+// mapped straight into the game. Everything is little endian:
+//
+//     LevelFileHeader
+//     layerCount layers of width * height uint16_t tile ids at tilesOffset, 0-based and row-major
+//     like a TileLayer, the first is the level's collision layer and the rest its overlays
+//     objectCount LevelObject records at objectsOffset
+#define LEVEL_FILE_MAGIC "FLVL"
+#define LEVEL_FILE_VERSION 2
+
+struct LevelFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t layerCount;
+	uint32_t tilesOffset;
+	uint32_t objectCount;
+	uint32_t objectsOffset;
+};
+
+struct LevelObject {
+	// an EntityStore::ENTITY_TYPE
+	uint32_t type;
+	// world position
+	float x;
+	float y;
+};
+
+// Maps a compiled level and points state's tile layers into it. Returns false without a message
+// if the file isn't there, so callers can fall back to the text export.
+bool LoadCompiledLevel(const std::string& levelFile, GameState* state);
+
+// Writes state's tile layers and entities as a compiled level, every layer must be the same size
+bool SaveCompiledLevel(const std::string& levelFile, const GameState* state);
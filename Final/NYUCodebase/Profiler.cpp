@@ -0,0 +1,73 @@
+#include "Profiler.h"
+
+#ifdef PROFILE_ENABLED
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+static const std::chrono::steady_clock::time_point profileStart = std::chrono::steady_clock::now();
+
+// Buffers are never freed so a thread that already exited can still be written out
+static std::mutex buffersMutex;
+static std::vector<ProfileBuffer*> buffers;
+
+uint64_t Profiler::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profileStart).count();
+}
+
+ProfileBuffer& Profiler::ThreadBuffer() {
+	// only a thread's first event takes the lock
+	thread_local ProfileBuffer* buffer = nullptr;
+	if (buffer == nullptr) {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer = new ProfileBuffer((unsigned int)buffers.size());
+		buffers.push_back(buffer);
+	}
+	return *buffer;
+}
+
+bool Profiler::WriteTrace(const std::string& traceFile) {
+	std::vector<ProfileBuffer*> threads;
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		threads = buffers;
+	}
+	FILE* file = fopen(traceFile.c_str(), "w");
+	if (file == NULL) {
+		std::cout << "Unable to write trace " << traceFile << std::endl;
+		return false;
+	}
+	fputs("{\"traceEvents\":[\n", file);
+	bool first = true;
+	size_t written = 0;
+	std::vector<ProfileEvent> events;
+	for (ProfileBuffer* buffer : threads) {
+		size_t head = buffer->head.load(std::memory_order_acquire);
+		size_t begin = head > ProfileBuffer::CAPACITY ? head - ProfileBuffer::CAPACITY : 0;
+		events.clear();
+		for (size_t i = begin; i < head; ++i) {
+			events.push_back(buffer->events[i & (ProfileBuffer::CAPACITY - 1)]);
+		}
+		// the owner kept recording while we copied, drop whatever it may have overwritten
+		size_t after = buffer->head.load(std::memory_order_acquire);
+		size_t overwritten = after > ProfileBuffer::CAPACITY ? after - ProfileBuffer::CAPACITY : 0;
+		size_t skip = overwritten > begin ? std::min(overwritten - begin, events.size()) : 0;
+		for (size_t i = skip; i < events.size(); ++i) {
+			const ProfileEvent& event = events[i];
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+				event.name, buffer->threadId, event.start / 1000.0, (event.end - event.start) / 1000.0);
+			first = false;
+			++written;
+		}
+	}
+	fputs("\n]}\n", file);
+	fclose(file);
+	std::cout << "Wrote " << written << " profile events to " << traceFile << std::endl;
+	return true;
+}
+
+#endif
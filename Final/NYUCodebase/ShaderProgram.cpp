@@ -1,7 +1,16 @@
 
 #include "ShaderProgram.h"
+#include <string.h>
 
-ShaderProgram::ShaderProgram(const char *vertexShaderFile, const char *fragmentShaderFile) {
+// a fresh context has no program, texture 0 and every attribute disabled
+GLuint ShaderProgram::currentProgram = 0;
+GLuint ShaderProgram::boundTexture = 0;
+unsigned int ShaderProgram::enabledAttributes = 0;
+unsigned int ShaderProgram::knownAttributes = ~0u;
+unsigned long ShaderProgram::requestedCalls = 0;
+unsigned long ShaderProgram::skippedCalls = 0;
+
+ShaderProgram::ShaderProgram(const char *vertexShaderFile, const char *fragmentShaderFile) : modelviewMatrixSet(false), projectionMatrixSet(false) {
     
     // create the vertex shader
     vertexShader = LoadShaderFromFile(vertexShaderFile, GL_VERTEX_SHADER);
@@ -29,6 +38,7 @@ ShaderProgram::ShaderProgram(const char *vertexShaderFile, const char *fragmentS
 }
 
 ShaderProgram::~ShaderProgram() {
+    if (currentProgram == programID) currentProgram = 0;
     glDeleteProgram(programID);
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
@@ -80,12 +90,86 @@ GLuint ShaderProgram::LoadShaderFromString(const std::string &shaderContents, GL
 }
 
 
-void ShaderProgram::SetModelviewMatrix(const Matrix &matrix) {
+void ShaderProgram::Use() {
+    ++requestedCalls;
+    if (currentProgram == programID) {
+        ++skippedCalls;
+        return;
+    }
     glUseProgram(programID);
+    currentProgram = programID;
+}
+
+void ShaderProgram::SetModelviewMatrix(const Matrix &matrix) {
+    Use();
+    ++requestedCalls;
+    if (modelviewMatrixSet && memcmp(modelviewMatrix.m, matrix.m, sizeof(matrix.m)) == 0) {
+        ++skippedCalls;
+        return;
+    }
     glUniformMatrix4fv(modelviewMatrixUniform, 1, GL_FALSE, matrix.ml);
+    modelviewMatrix = matrix;
+    modelviewMatrixSet = true;
 }
 
 void ShaderProgram::SetProjectionMatrix(const Matrix &matrix) {
-    glUseProgram(programID);
-    glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, matrix.ml);    
+    Use();
+    ++requestedCalls;
+    if (projectionMatrixSet && memcmp(projectionMatrix.m, matrix.m, sizeof(matrix.m)) == 0) {
+        ++skippedCalls;
+        return;
+    }
+    glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, matrix.ml);
+    projectionMatrix = matrix;
+    projectionMatrixSet = true;
+}
+
+void ShaderProgram::BindTexture(GLuint texture) {
+    ++requestedCalls;
+    if (boundTexture == texture) {
+        ++skippedCalls;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    boundTexture = texture;
+}
+
+void ShaderProgram::EnableAttribute(GLuint attribute) {
+    ++requestedCalls;
+    if (attribute < 32 && (knownAttributes & enabledAttributes & (1u << attribute))) {
+        ++skippedCalls;
+        return;
+    }
+    glEnableVertexAttribArray(attribute);
+    if (attribute < 32) {
+        enabledAttributes |= 1u << attribute;
+        knownAttributes |= 1u << attribute;
+    }
+}
+
+void ShaderProgram::DisableAttribute(GLuint attribute) {
+    ++requestedCalls;
+    if (attribute < 32 && (knownAttributes & ~enabledAttributes & (1u << attribute))) {
+        ++skippedCalls;
+        return;
+    }
+    glDisableVertexAttribArray(attribute);
+    if (attribute < 32) {
+        enabledAttributes &= ~(1u << attribute);
+        knownAttributes |= 1u << attribute;
+    }
+}
+
+void ShaderProgram::TextureDeleted(GLuint texture) {
+    if (boundTexture == texture) boundTexture = 0;
+}
+
+void ShaderProgram::ForgetState() {
+    currentProgram = UNKNOWN_NAME;
+    boundTexture = UNKNOWN_NAME;
+    knownAttributes = 0;
+}
+
+void ShaderProgram::PrintStats() {
+    std::cout << "GL state: " << requestedCalls << " calls, " << skippedCalls << " skipped as no-ops" << std::endl;
 }
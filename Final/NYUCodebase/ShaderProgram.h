@@ -15,8 +15,26 @@ class ShaderProgram {
         ShaderProgram(const char *vertexShaderFile, const char *fragmentShaderFile);
         ~ShaderProgram();
     
+        // Makes this the current program, skipped when it already is
+        void Use();
+        // Both make the program current and skip the upload when the matrix is the one last sent
         void SetModelviewMatrix(const Matrix &matrix);
         void SetProjectionMatrix(const Matrix &matrix);
+
+        // The rest of the GL state the games change per draw, shared by every program since it
+        // belongs to the context. Each call is skipped when it wouldn't change anything, so state
+        // changed behind the cache's back needs ForgetState() before the next call.
+        static void BindTexture(GLuint texture);
+        static void EnableAttribute(GLuint attribute);
+        static void DisableAttribute(GLuint attribute);
+        // glDeleteTextures unbinds a bound texture and the name can come back from glGenTextures
+        static void TextureDeleted(GLuint texture);
+        static void ForgetState();
+
+        // GL calls asked for through the cache, and how many of them it skipped as no-ops
+        static unsigned long requestedCalls;
+        static unsigned long skippedCalls;
+        static void PrintStats();
     
         GLuint LoadShaderFromString(const std::string &shaderContents, GLenum type);
         GLuint LoadShaderFromFile(const std::string &shaderFile, GLenum type);
@@ -31,4 +49,20 @@ class ShaderProgram {
     
         GLuint vertexShader;
         GLuint fragmentShader;
+
+    private:
+        // what each uniform was last set to, valid once its flag is set
+        Matrix modelviewMatrix;
+        Matrix projectionMatrix;
+        bool modelviewMatrixSet;
+        bool projectionMatrixSet;
+
+        // after ForgetState, matches no program or texture GL hands out
+        static const GLuint UNKNOWN_NAME = ~0u;
+        static GLuint currentProgram;
+        static GLuint boundTexture;
+        // one bit per attribute location below 32, higher ones are never cached. An attribute's
+        // enabled bit means nothing until its known bit is set.
+        static unsigned int enabledAttributes;
+        static unsigned int knownAttributes;
 };
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed size ring for exactly one producer thread and one consumer thread. Neither side ever
+// takes a lock or waits, a full or empty queue just fails the call.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	// Producer only
+	bool TryPush(const T& value) {
+		size_t write = tail.load(std::memory_order_relaxed);
+		if (write - head.load(std::memory_order_acquire) == CAPACITY) return false;
+		items[write & (CAPACITY - 1)] = value;
+		tail.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only
+	bool TryPop(T& value) {
+		size_t read = head.load(std::memory_order_relaxed);
+		if (read == tail.load(std::memory_order_acquire)) return false;
+		value = items[read & (CAPACITY - 1)];
+		head.store(read + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only
+	bool Empty() const {
+		return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	T items[CAPACITY];
+	// each index on its own cache line so the two threads don't fight over one
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
@@ -0,0 +1,197 @@
+#include "StateLoader.h"
+#include "LevelFile.h"
+#include "Profiler.h"
+#include "TmxLoader.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+StateLoader::StateLoader(StateResources& resources) : unloadOnLeave(false), prefetchNext(true), resources(resources), current(0), stopping(false) {}
+
+StateLoader::~StateLoader() {
+	UnloadAll();
+	for (auto& tileset : tilesets) delete tileset.second;
+}
+
+bool StateLoader::LoadManifest(const std::string& manifestFile) {
+	std::ifstream infile(manifestFile);
+	if (!infile) {
+		std::cout << "Unable to open state manifest " << manifestFile << std::endl;
+		return false;
+	}
+	std::string line;
+	int lineNumber = 0;
+	while (getline(infile, line)) {
+		++lineNumber;
+		std::istringstream sStream(line);
+		std::string type;
+		if (!(sStream >> type) || type[0] == '#') continue;
+		StateEntry entry;
+		if (type == "menu") entry.type = GameState::STATE_MENU;
+		else if (type == "game") entry.type = GameState::STATE_GAME;
+		else if (type == "win") entry.type = GameState::STATE_WIN;
+		else if (type == "lose") entry.type = GameState::STATE_LOSE;
+		else {
+			std::cout << manifestFile << ":" << lineNumber << ": unknown state type " << type << std::endl;
+			return false;
+		}
+		if (!(sStream >> entry.level >> entry.texture)) {
+			std::cout << manifestFile << ":" << lineNumber << ": expected a level and a texture" << std::endl;
+			return false;
+		}
+		sStream >> entry.tileset;
+		entries.push_back(entry);
+	}
+	if (entries.empty()) {
+		std::cout << manifestFile << ": no states" << std::endl;
+		return false;
+	}
+	states.assign(entries.size(), nullptr);
+	inFlight.assign(entries.size(), false);
+	return true;
+}
+
+size_t StateLoader::Find(GameState::STATE_TYPE type) const {
+	size_t index = 0;
+	while (index < entries.size() && entries[index].type != type) ++index;
+	return index;
+}
+
+GameState* StateLoader::Enter(size_t index) {
+	if (index >= states.size()) return nullptr;
+	if (inFlight[index]) {
+		// only a hitch if the player got here before the loader thread did
+		PROFILE_SCOPE("StateLoader::Wait");
+		while (inFlight[index]) {
+			Poll();
+			std::this_thread::yield();
+		}
+		if (states[index] == nullptr) return nullptr;
+	}
+	if (states[index] == nullptr) {
+		GameState* state = Parse(index);
+		if (state == nullptr) return nullptr;
+		Finish(index, state);
+	}
+	// the new state is in before the old one goes, so a texture both use is never reloaded
+	if (unloadOnLeave && current != index) Unload(current);
+	current = index;
+	if (prefetchNext && index + 1 < states.size()) Prefetch(index + 1);
+	return states[index];
+}
+
+void StateLoader::Prefetch(size_t index) {
+	if (index >= states.size() || states[index] || inFlight[index]) return;
+	if (!loader.joinable()) loader = std::thread(&StateLoader::LoaderThread, this);
+	// a full queue means plenty is already on its way, this one loads when entered
+	if (!requests.TryPush(index)) return;
+	inFlight[index] = true;
+	// taking the lock after the push means the loader either sees the request or is already waiting
+	std::lock_guard<std::mutex> lock(wakeLock);
+	wake.notify_one();
+}
+
+void StateLoader::Poll() {
+	LoadResult result;
+	while (results.TryPop(result)) {
+		inFlight[result.index] = false;
+		if (result.state) Finish(result.index, result.state);
+	}
+}
+
+void StateLoader::LoaderThread() {
+	while (!stopping) {
+		size_t index;
+		if (requests.TryPop(index)) {
+			LoadResult result = { index, Parse(index) };
+			// there are never more results than requests, so this only spins if Poll falls behind
+			while (!results.TryPush(result)) std::this_thread::yield();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(wakeLock);
+		wake.wait(lock, [this] { return stopping || !requests.Empty(); });
+	}
+}
+
+void StateLoader::StopLoader() {
+	if (!loader.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(wakeLock);
+		stopping = true;
+	}
+	wake.notify_one();
+	loader.join();
+	stopping = false;
+	// with the thread gone this side can drain both queues
+	size_t index;
+	while (requests.TryPop(index)) inFlight[index] = false;
+	LoadResult result;
+	while (results.TryPop(result)) {
+		inFlight[result.index] = false;
+		if (result.state) delete result.state;
+	}
+}
+
+void StateLoader::Unload(size_t index) {
+	GameState* state = states[index];
+	if (state == nullptr) return;
+	resources.Unloading(state);
+	resources.ReleaseTexture(state->tileTexture);
+	delete state;
+	states[index] = nullptr;
+}
+
+void StateLoader::UnloadAll() {
+	StopLoader();
+	for (size_t i = 0; i < states.size(); ++i) Unload(i);
+}
+
+GameState* StateLoader::Parse(size_t index) {
+	PROFILE_SCOPE("StateLoader::Parse");
+	const StateEntry& entry = entries[index];
+	GameState* state = new GameState(entry.type);
+	if (!entry.tileset.empty()) {
+		std::lock_guard<std::mutex> lock(tilesetLock);
+		TileProperties*& properties = tilesets[entry.tileset];
+		if (properties == nullptr) {
+			properties = new TileProperties();
+			if (!properties->Load(entry.tileset)) {
+				std::cout << "Unable to read tileset " << entry.tileset << std::endl;
+				delete properties;
+				properties = nullptr;
+				delete state;
+				return nullptr;
+			}
+		}
+		state->tileProperties = properties;
+	}
+	resources.DecodeTexture(entry.texture.c_str());
+	// placing entities copies these, Finish points them at the real texture
+	if (entry.type == GameState::STATE_GAME) AssignLevelSprites(state);
+
+	// compiled levels map in without parsing, the Tiled maps they were built from are the fallback
+	bool loaded = LoadCompiledLevel(entry.level + ".lvl", state) || LoadTmxLevel(entry.level + ".tmx", state);
+	if (loaded && entry.type == GameState::STATE_GAME && (state->entities.Size() < 2 || state->entities.type[0] != EntityStore::ENTITY_PLAYER)) {
+		std::cout << entry.level << ": a level needs the player and at least one other entity" << std::endl;
+		loaded = false;
+	}
+	if (!loaded) {
+		std::cout << "Unable to load state " << index << " from " << entry.level << std::endl;
+		delete state;
+		return nullptr;
+	}
+	return state;
+}
+
+void StateLoader::Finish(size_t index, GameState* state) {
+	PROFILE_SCOPE("StateLoader::Finish");
+	state->tileTexture = resources.LoadTexture(entries[index].texture.c_str());
+	if (state->type == GameState::STATE_GAME) {
+		AssignLevelSprites(state);
+		EntityStore& entities = state->entities;
+		for (size_t i = 0; i < entities.Size(); ++i) entities.detail[i].sprite = state->sprites[entities.type[i]];
+		AssignEntityFrames(state);
+	}
+	states[index] = state;
+	resources.Loaded(state);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Game.h"
+#include "SpscQueue.h"
+
+// What the front end has to provide or tear down when a state comes and goes. The defaults do
+// nothing, which is all a headless run needs.
+class StateResources {
+public:
+	virtual ~StateResources() {}
+	// Runs on the loader thread ahead of LoadTexture so the image is already in memory by then.
+	// Must not touch GL.
+	virtual void DecodeTexture(const char* filePath) {}
+	// Returns the texture for an image file, 0 when there is nothing to draw with
+	virtual unsigned int LoadTexture(const char* filePath) { return 0; }
+	virtual void ReleaseTexture(unsigned int texture) {}
+	// Called once a state is fully loaded, before its first step
+	virtual void Loaded(GameState* state) {}
+	// Called before a state's memory is freed
+	virtual void Unloading(GameState* state) {}
+};
+
+// One line of the manifest
+struct StateEntry {
+	GameState::STATE_TYPE type;
+	// compiled as level.lvl, or the level.tmx it was built from
+	std::string level;
+	std::string texture;
+	// .tsx with the tile flags, empty for states without collision
+	std::string tileset;
+};
+
+// The game's states in manifest order. Nothing is read until a state is first entered, so startup
+// only pays for the menu and memory follows the states actually visited.
+//
+// Entering a state starts reading the one after it on a loader thread while the game plays on.
+// The thread only parses and decodes; a finished state comes back through a lock-free queue and
+// Poll() does the rest (textures, sprites, the Loaded hook) on the main thread.
+class StateLoader {
+public:
+	StateLoader(StateResources& resources);
+	~StateLoader();
+
+	// Lines of "type level texture [tileset]", type being menu, game, win or lose. Call before
+	// entering any state.
+	bool LoadManifest(const std::string& manifestFile);
+
+	size_t Count() const { return entries.size(); }
+	GameState::STATE_TYPE Type(size_t index) const { return entries[index].type; }
+	const StateEntry& Entry(size_t index) const { return entries[index]; }
+	// First state of a type, Count() if there is none
+	size_t Find(GameState::STATE_TYPE type) const;
+
+	// Makes index the current state, loading it if needed or waiting for the loader thread if it
+	// is already on it. Returns null if it can't be loaded, in which case the current state stays
+	// as it was.
+	GameState* Enter(size_t index);
+	// Starts loading index in the background, nothing happens if it is loaded or on its way
+	void Prefetch(size_t index);
+	// Finishes whatever the loader thread has ready, call once a frame on the main thread
+	void Poll();
+	size_t Current() const { return current; }
+	// Null until the state has been loaded
+	GameState* Get(size_t index) const { return states[index]; }
+
+	void Unload(size_t index);
+	// Stops the loader thread too. Call while the front end can still free what Unloading hands it.
+	void UnloadAll();
+
+	// Free a state as soon as the game leaves it instead of keeping every visited state resident
+	bool unloadOnLeave;
+	// Start on the next state in the manifest whenever one is entered
+	bool prefetchNext;
+
+private:
+	struct LoadResult {
+		size_t index;
+		// null if it failed to load
+		GameState* state;
+	};
+
+	// Everything that doesn't need the main thread, safe to run on the loader thread
+	GameState* Parse(size_t index);
+	void Finish(size_t index, GameState* state);
+	void LoaderThread();
+	void StopLoader();
+
+	StateResources& resources;
+	std::vector<StateEntry> entries;
+	std::vector<GameState*> states;
+	// requested from the loader thread and not finished yet
+	std::vector<bool> inFlight;
+	// shared by every level drawn from the same tileset, kept for the loader's lifetime
+	std::map<std::string, TileProperties*> tilesets;
+	std::mutex tilesetLock;
+	size_t current;
+
+	std::thread loader;
+	SpscQueue<size_t, 16> requests;
+	SpscQueue<LoadResult, 16> results;
+	// only for sleeping while there are no requests, the queues themselves never lock
+	std::mutex wakeLock;
+	std::condition_variable wake;
+	std::atomic<bool> stopping;
+};
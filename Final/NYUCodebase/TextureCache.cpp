@@ -0,0 +1,218 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "ShaderProgram.h"
+#include "stb_image.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <cassert>
+
+TextureCache::TextureCache() : decodes(0), prefetched(0), hits(0), decodeMilliseconds(0.0), residentBytes(0), diskHits(0), diskCacheDirectory("texcache") {}
+
+// Start of every disk cache file, the pixels follow straight after
+struct DiskCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+};
+static const uint32_t DISK_CACHE_VERSION = 1;
+
+// FNV-1a, plenty to tell one image or one version of it from another
+static uint64_t hashBytes(const unsigned char* data, size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * 1099511628211ull;
+	return hash;
+}
+
+static std::string toHex(uint64_t value) {
+	char text[17];
+	snprintf(text, sizeof(text), "%016llx", (unsigned long long)value);
+	return text;
+}
+
+TextureCache::Decoded TextureCache::DecodeFile(const std::string& filePath) const {
+	auto start = std::chrono::high_resolution_clock::now();
+	Decoded image;
+	MappedFile source;
+	if (!source.Open(filePath)) return image;
+	std::string cacheFile;
+	std::string prefix;
+	if (!diskCacheDirectory.empty()) {
+		prefix = toHex(hashBytes((const unsigned char*)filePath.data(), filePath.size())) + "-";
+		cacheFile = diskCacheDirectory + "/" + prefix + toHex(hashBytes(source.Data(), source.Size())) + ".rgba";
+	}
+	if (cacheFile.empty() || !ReadDiskCache(cacheFile, image)) {
+		int comp;
+		image.owned = stbi_load_from_memory(source.Data(), (int)source.Size(), &image.width, &image.height, &comp, STBI_rgb_alpha);
+		image.pixels = image.owned;
+		if (image.owned != NULL && !cacheFile.empty()) WriteDiskCache(cacheFile, prefix, image);
+	}
+	std::chrono::duration<double, std::milli> took = std::chrono::high_resolution_clock::now() - start;
+	image.milliseconds = took.count();
+	return image;
+}
+
+bool TextureCache::ReadDiskCache(const std::string& cacheFile, Decoded& image) {
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	DiskCacheHeader header;
+	if (!file->Open(cacheFile) || file->Size() < sizeof(header)) return false;
+	memcpy(&header, file->Data(), sizeof(header));
+	// anything that doesn't add up is decoded again and overwritten
+	if (memcmp(header.magic, "RGBA", 4) != 0 || header.version != DISK_CACHE_VERSION
+		|| header.width == 0 || header.height == 0 || header.width > 16384 || header.height > 16384
+		|| file->Size() != sizeof(header) + (size_t)header.width * header.height * 4) {
+		return false;
+	}
+	image.pixels = file->Data() + sizeof(header);
+	image.mapped = file;
+	image.width = header.width;
+	image.height = header.height;
+	image.fromDisk = true;
+	return true;
+}
+
+void TextureCache::WriteDiskCache(const std::string& cacheFile, const std::string& stalePrefix, const Decoded& image) {
+	std::filesystem::path directory = std::filesystem::path(cacheFile).parent_path();
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	// earlier versions of the same image can never be hit again
+	for (const auto& old : std::filesystem::directory_iterator(directory, error)) {
+		if (old.path().filename().string().compare(0, stalePrefix.size(), stalePrefix) == 0) {
+			std::filesystem::remove(old.path(), error);
+		}
+	}
+	DiskCacheHeader header = { { 'R', 'G', 'B', 'A' }, DISK_CACHE_VERSION, (uint32_t)image.width, (uint32_t)image.height };
+	// written aside and renamed into place so a crash never leaves a short file under the real name
+	std::string temporary = cacheFile + ".tmp";
+	{
+		std::ofstream outfile(temporary, std::ios::binary);
+		outfile.write((const char*)&header, sizeof(header));
+		outfile.write((const char*)image.pixels, (std::streamsize)image.width * image.height * 4);
+		if (!outfile) {
+			std::cout << "Unable to write texture cache " << temporary << std::endl;
+			outfile.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, cacheFile, error);
+}
+
+void TextureCache::FreePixels(Decoded& image) {
+	if (image.owned != NULL) stbi_image_free(image.owned);
+	image.owned = NULL;
+	image.mapped.reset();
+	image.pixels = NULL;
+}
+
+void TextureCache::Decode(const std::string& filePath) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (entries.count(filePath) || decoded.count(filePath) || decoding.count(filePath)) return;
+		decoding.insert(filePath);
+	}
+	// a failure is left for Acquire to report
+	Decoded image = DecodeFile(filePath);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		decoding.erase(filePath);
+		if (image.pixels != NULL) decoded[filePath] = image;
+	}
+	decodeFinished.notify_all();
+}
+
+GLuint TextureCache::Acquire(const std::string& filePath) {
+	Decoded image;
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		decodeFinished.wait(guard, [&] { return decoding.count(filePath) == 0; });
+		auto found = entries.find(filePath);
+		if (found != entries.end()) {
+			++found->second.references;
+			++hits;
+			return found->second.texture;
+		}
+		auto ready = decoded.find(filePath);
+		if (ready != decoded.end()) {
+			image = ready->second;
+			decoded.erase(ready);
+			++prefetched;
+		}
+		// in neither map until the upload is done, so Decode has to see it here or it decodes it again
+		decoding.insert(filePath);
+	}
+
+	if (image.pixels == NULL) image = DecodeFile(filePath);
+	if (image.pixels == NULL) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			decoding.erase(filePath);
+		}
+		decodeFinished.notify_all();
+		std::cout << "Unable to load image. Make sure the path is correct\n";
+		assert(false);
+		return 0;
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	GLuint retTexture;
+	glGenTextures(1, &retTexture);
+	ShaderProgram::BindTexture(retTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+	// NEAREST
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	FreePixels(image);
+	std::chrono::duration<double, std::milli> took = std::chrono::high_resolution_clock::now() - start;
+
+	++decodes;
+	if (image.fromDisk) ++diskHits;
+	decodeMilliseconds += image.milliseconds + took.count();
+	residentBytes += (size_t)image.width * image.height * 4;
+	Entry entry = { retTexture, image.width, image.height, 1 };
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		decoding.erase(filePath);
+		entries[filePath] = entry;
+	}
+	decodeFinished.notify_all();
+	return retTexture;
+}
+
+void TextureCache::Release(GLuint texture) {
+	std::lock_guard<std::mutex> guard(lock);
+	for (auto it = entries.begin(); it != entries.end(); ++it) {
+		if (it->second.texture == texture) {
+			if (--it->second.references <= 0) {
+				glDeleteTextures(1, &it->second.texture);
+				ShaderProgram::TextureDeleted(it->second.texture);
+				residentBytes -= (size_t)it->second.width * it->second.height * 4;
+				entries.erase(it);
+			}
+			return;
+		}
+	}
+}
+
+void TextureCache::Clear() {
+	std::lock_guard<std::mutex> guard(lock);
+	for (auto& entry : entries) {
+		glDeleteTextures(1, &entry.second.texture);
+		ShaderProgram::TextureDeleted(entry.second.texture);
+	}
+	entries.clear();
+	for (auto& image : decoded) {
+		FreePixels(image.second);
+	}
+	decoded.clear();
+	residentBytes = 0;
+}
+
+void TextureCache::PrintStats() const {
+	std::cout << "Textures: " << entries.size() << " resident (" << residentBytes / 1024 << " KB), "
+		<< decodes << " decoded in " << decodeMilliseconds << " ms (" << prefetched << " ahead of time, " << diskHits << " from disk), " << hits << " cache hits\n";
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+class MappedFile;
+
+// Path-keyed, reference-counted texture store so each image is decoded and uploaded only once
+class TextureCache {
+public:
+	TextureCache();
+
+	// Decodes an image into memory ahead of Acquire, which then only has to upload it. The one
+	// call that's safe from any thread, everything else belongs to the GL thread. Several threads
+	// can decode different images at once, asking twice for the same one decodes it once.
+	void Decode(const std::string& filePath);
+	GLuint Acquire(const std::string& filePath);
+	void Release(GLuint texture);
+	// Deletes every texture regardless of references, call while the GL context is still alive
+	void Clear();
+
+	size_t Count() const { return entries.size(); }
+	void PrintStats() const;
+
+	int decodes;
+	// of those, decoded ahead of time by Decode
+	int prefetched;
+	int hits;
+	double decodeMilliseconds;
+	size_t residentBytes;
+	// of decodes, read back from the disk cache instead of inflating the PNG
+	int diskHits;
+
+	// Decoded pixels are kept here between runs as <path hash>-<content hash>.rgba, written the first
+	// time an image is decoded and mapped straight in after that. Empty turns it off. Set before the
+	// first Decode or Acquire.
+	std::string diskCacheDirectory;
+
+private:
+	struct Entry {
+		GLuint texture;
+		int width;
+		int height;
+		int references;
+	};
+	struct Decoded {
+		Decoded() : pixels(NULL), owned(NULL), width(0), height(0), milliseconds(0.0), fromDisk(false) {}
+		// width * height RGBA8, pointing into either owned or mapped
+		const unsigned char* pixels;
+		// from stb_image when the PNG had to be decoded
+		unsigned char* owned;
+		std::shared_ptr<MappedFile> mapped;
+		int width;
+		int height;
+		double milliseconds;
+		bool fromDisk;
+	};
+	Decoded DecodeFile(const std::string& filePath) const;
+	static bool ReadDiskCache(const std::string& cacheFile, Decoded& image);
+	static void WriteDiskCache(const std::string& cacheFile, const std::string& stalePrefix, const Decoded& image);
+	static void FreePixels(Decoded& image);
+
+	// guards the maps and set, Decode checks entries so it doesn't decode what is already uploaded
+	std::mutex lock;
+	std::map<std::string, Entry> entries;
+	std::map<std::string, Decoded> decoded;
+	// being decoded or uploaded right now, Acquire waits for these rather than decoding them again
+	std::set<std::string> decoding;
+	std::condition_variable decodeFinished;
+};
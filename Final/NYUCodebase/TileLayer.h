@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+class MappedFile;
+
+// One tile layer as a single contiguous row-major buffer of 16-bit tile ids, 0 is empty.
+// The buffer is either owned by the layer or, for compiled levels, read in place from a
+// memory-mapped file, in which case the layer is read-only.
+class TileLayer {
+public:
+	TileLayer() : width(0), height(0), mapped(nullptr) {}
+
+	// Reallocates the layer and clears every tile to empty
+	void Resize(int width, int height) {
+		assert(width >= 0 && height >= 0);
+		this->width = width;
+		this->height = height;
+		file.reset();
+		mapped = nullptr;
+		tiles.assign((size_t)width * height, 0);
+	}
+
+	// Points the layer at width * height tiles inside a mapped file, kept open as long as the layer uses it
+	void Map(const std::shared_ptr<MappedFile>& file, const uint16_t* data, int width, int height) {
+		assert(width >= 0 && height >= 0);
+		this->width = width;
+		this->height = height;
+		this->file = file;
+		mapped = data;
+		tiles.clear();
+		tiles.shrink_to_fit();
+	}
+	bool IsMapped() const { return mapped != nullptr; }
+
+	int Width() const { return width; }
+	int Height() const { return height; }
+	size_t Size() const { return (size_t)width * height; }
+	bool Contains(int x, int y) const { return x >= 0 && y >= 0 && x < width && y < height; }
+
+	// Tile at (x, y), or empty outside the layer
+	uint16_t Get(int x, int y) const { return Contains(x, y) ? Data()[(size_t)y * width + x] : 0; }
+	void Set(int x, int y, uint16_t tile) {
+		assert(Contains(x, y));
+		Data()[(size_t)y * width + x] = tile;
+	}
+
+	const uint16_t* Row(int y) const { return Data() + (size_t)y * width; }
+	uint16_t* Row(int y) { return Data() + (size_t)y * width; }
+	const uint16_t* Data() const { return mapped ? mapped : tiles.data(); }
+	uint16_t* Data() {
+		assert(!mapped);
+		return tiles.data();
+	}
+
+private:
+	int width;
+	int height;
+	std::vector<uint16_t> tiles;
+	std::shared_ptr<MappedFile> file;
+	const uint16_t* mapped;
+};
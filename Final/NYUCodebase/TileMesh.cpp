@@ -0,0 +1,81 @@
+#include "TileMesh.h"
+#include "Profiler.h"
+#include <vector>
+
+// x, y, u, v
+#define TILE_VERTEX_FLOATS 4
+
+TileMesh::TileMesh() : vertexBuffer(0), vertexCount(0) {}
+
+TileMesh::~TileMesh() {
+	Clear();
+}
+
+void TileMesh::Build(const TileLayer& layer, float tileSize, const TileSheet& sheet) {
+	Build(std::vector<const TileLayer*>(1, &layer), tileSize, sheet);
+}
+
+void TileMesh::Build(const std::vector<const TileLayer*>& layers, float tileSize, const TileSheet& sheet) {
+	PROFILE_SCOPE("TileMesh::Build");
+	std::vector<float> vertexData;
+	size_t tiles = 0;
+	for (const TileLayer* layer : layers) tiles += layer->Size();
+	vertexData.reserve(tiles * 6 * TILE_VERTEX_FLOATS);
+	float spriteWidth = sheet.spriteWidth / sheet.sheetWidth;
+	float spriteHeight = sheet.spriteHeight / sheet.sheetHeight;
+	for (const TileLayer* layer : layers) {
+		// if index 0 is an empty tile
+		for (int y = 0; y < layer->Height(); y++) {
+			const uint16_t* row = layer->Row(y);
+			for (int x = 0; x < layer->Width(); x++) {
+				int tile = row[x];
+				if (tile) {
+					float u = (sheet.margin + (sheet.stride * (tile % sheet.columns))) / sheet.sheetWidth;
+					float v = (sheet.margin + (sheet.stride * (tile / sheet.columns))) / sheet.sheetHeight;
+					float left = tileSize * x;
+					float right = left + tileSize;
+					float top = -tileSize * y;
+					float bottom = top - tileSize;
+					vertexData.insert(vertexData.end(), {
+						left, top, u, v,
+						left, bottom, u, v + spriteHeight,
+						right, bottom, u + spriteWidth, v + spriteHeight,
+						left, top, u, v,
+						right, bottom, u + spriteWidth, v + spriteHeight,
+						right, top, u + spriteWidth, v
+					});
+				}
+			}
+		}
+	}
+
+	if (vertexBuffer == 0) {
+		glGenBuffers(1, &vertexBuffer);
+	}
+	vertexCount = (GLsizei)(vertexData.size() / TILE_VERTEX_FLOATS);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.empty() ? NULL : &vertexData[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TileMesh::Draw(ShaderProgram& program) const {
+	if (vertexCount == 0) return;
+	const GLsizei stride = TILE_VERTEX_FLOATS * sizeof(float);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, stride, (void*)0);
+	ShaderProgram::EnableAttribute(program.positionAttribute);
+	glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, stride, (void*)(2 * sizeof(float)));
+	ShaderProgram::EnableAttribute(program.texCoordAttribute);
+	glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+
+	// entities still draw from client-side arrays
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TileMesh::Clear() {
+	if (vertexBuffer != 0) {
+		glDeleteBuffers(1, &vertexBuffer);
+		vertexBuffer = 0;
+	}
+	vertexCount = 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include "ShaderProgram.h"
+#include <vector>
+#include "TileLayer.h"
+
+// Layout of a tile sheet in pixels
+struct TileSheet {
+	float sheetWidth;
+	float sheetHeight;
+	int columns;
+	int margin;
+	int stride;
+	int spriteWidth;
+	int spriteHeight;
+};
+
+// Static tile layer geometry, tessellated once when the level is loaded and kept in a VBO
+class TileMesh {
+public:
+	TileMesh();
+	~TileMesh();
+	TileMesh(const TileMesh&) = delete;
+	TileMesh& operator=(const TileMesh&) = delete;
+
+	void Build(const TileLayer& layer, float tileSize, const TileSheet& sheet);
+	// All layers in one buffer, each drawn over the ones before it
+	void Build(const std::vector<const TileLayer*>& layers, float tileSize, const TileSheet& sheet);
+	void Draw(ShaderProgram& program) const;
+	void Clear();
+
+	GLuint vertexBuffer;
+	GLsizei vertexCount;
+};
@@ -0,0 +1,47 @@
+#include "TileProperties.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+// Value of attribute name inside the tag starting at tagStart, or "" if absent
+static std::string attribute(const std::string& text, size_t tagStart, const char* name) {
+	size_t tagEnd = text.find('>', tagStart);
+	std::string key = std::string(" ") + name + "=\"";
+	size_t found = text.find(key, tagStart);
+	if (found == std::string::npos || found > tagEnd) return "";
+	size_t valueStart = found + key.size();
+	return text.substr(valueStart, text.find('"', valueStart) - valueStart);
+}
+
+bool TileProperties::Load(const std::string& tsxFile) {
+	std::ifstream infile(tsxFile);
+	if (infile.fail()) return false;
+	std::stringstream buffer;
+	buffer << infile.rdbuf();
+	const std::string text = buffer.str();
+
+	size_t tileset = text.find("<tileset");
+	if (tileset == std::string::npos) return false;
+	int tileCount = atoi(attribute(text, tileset, "tilecount").c_str());
+	if (tileCount <= 0) return false;
+	flags.assign(tileCount, 0);
+
+	size_t tile = text.find("<tile ", tileset);
+	while (tile != std::string::npos) {
+		int id = atoi(attribute(text, tile, "id").c_str());
+		size_t tagEnd = text.find('>', tile);
+		size_t tileEnd = (tagEnd != std::string::npos && text[tagEnd - 1] == '/') ? tagEnd : text.find("</tile>", tile);
+		size_t property = text.find("<property ", tile);
+		while (property != std::string::npos && property < tileEnd) {
+			std::string name = attribute(text, property, "name");
+			std::string value = attribute(text, property, "value");
+			if (id >= 0 && id < tileCount && (value == "true" || value == "1")) {
+				if (name == "solid") flags[id] |= TILE_SOLID;
+				else if (name == "hazard") flags[id] |= TILE_HAZARD;
+			}
+			property = text.find("<property ", property + 1);
+		}
+		tile = text.find("<tile ", tile + 1);
+	}
+	return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Flat per-tile flag table for one tileset, indexed by tile id (0-based, as stored in a TileLayer)
+class TileProperties {
+public:
+	enum TILE_FLAG : uint8_t { TILE_SOLID = 1 << 0, TILE_HAZARD = 1 << 1 };
+
+	// Reads tilecount and the boolean "solid"/"hazard" tile properties from a Tiled .tsx file
+	bool Load(const std::string& tsxFile);
+
+	bool Has(int tile, uint8_t flag) const {
+		return (unsigned)tile < flags.size() && (flags[tile] & flag) != 0;
+	}
+	bool IsSolid(int tile) const { return Has(tile, TILE_SOLID); }
+	bool IsHazard(int tile) const { return Has(tile, TILE_HAZARD); }
+
+	std::vector<uint8_t> flags;
+};
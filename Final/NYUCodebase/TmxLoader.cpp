@@ -0,0 +1,349 @@
+#include "TmxLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Only stb_image's inflate is needed here, built static so it can't clash with the image loader
+// main.cpp compiles
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wmisleading-indentation"
+#endif
+#include "stb_image.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// Tiled keeps flip and rotation flags in the top bits of a gid
+#define TMX_GID_MASK 0x1FFFFFFFu
+
+// Tilesets read by earlier maps, by path, so levels that share a .tsx share one flag table.
+// Levels can load on more than one thread.
+static std::map<std::string, TileProperties*> tilesets;
+static std::mutex tilesetLock;
+
+// One tag as the reader found it
+struct XmlTag {
+	std::string name;
+	bool closing;
+	bool selfClosing;
+	std::vector<std::pair<std::string, std::string>> attributes;
+
+	const std::string* Attribute(const char* key) const {
+		for (const auto& attribute : attributes) {
+			if (attribute.first == key) return &attribute.second;
+		}
+		return nullptr;
+	}
+	int IntAttribute(const char* key, int fallback) const {
+		const std::string* value = Attribute(key);
+		return value ? atoi(value->c_str()) : fallback;
+	}
+	float FloatAttribute(const char* key, float fallback) const {
+		const std::string* value = Attribute(key);
+		return value ? (float)atof(value->c_str()) : fallback;
+	}
+};
+
+// Walks the tags of an XML buffer in order, text between tags is left in place for the caller to decode
+class XmlReader {
+public:
+	XmlReader(const char* begin, const char* end) : position(begin), end(end) {}
+
+	bool Next(XmlTag& tag) {
+		while (true) {
+			while (position < end && *position != '<') ++position;
+			if (position >= end) return false;
+			if (Skip("<?", "?>") || Skip("<!--", "-->") || Skip("<!", ">")) continue;
+			break;
+		}
+		++position;
+		tag.closing = position < end && *position == '/';
+		if (tag.closing) ++position;
+		const char* name = position;
+		while (position < end && !isSpace(*position) && *position != '/' && *position != '>') ++position;
+		tag.name.assign(name, position);
+		tag.selfClosing = false;
+		tag.attributes.clear();
+		while (position < end) {
+			while (position < end && isSpace(*position)) ++position;
+			if (position >= end) break;
+			if (*position == '>') { ++position; return true; }
+			if (*position == '/') { tag.selfClosing = true; ++position; continue; }
+			const char* key = position;
+			while (position < end && *position != '=' && !isSpace(*position) && *position != '>') ++position;
+			std::string attributeName(key, position);
+			while (position < end && (isSpace(*position) || *position == '=')) ++position;
+			if (position >= end || (*position != '"' && *position != '\'')) break;
+			char quote = *position++;
+			const char* value = position;
+			while (position < end && *position != quote) ++position;
+			tag.attributes.emplace_back(attributeName, std::string(value, position));
+			if (position < end) ++position;
+		}
+		return false;
+	}
+
+	// Text following the last tag, up to the next one
+	void FollowingText(const char*& begin, const char*& finish) const {
+		begin = position;
+		finish = position;
+		while (finish < end && *finish != '<') ++finish;
+	}
+
+private:
+	static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+	bool Skip(const char* open, const char* close) {
+		size_t openLength = strlen(open);
+		if ((size_t)(end - position) < openLength || memcmp(position, open, openLength) != 0) return false;
+		const char* found = std::search(position + openLength, end, close, close + strlen(close));
+		position = found < end ? found + strlen(close) : end;
+		return true;
+	}
+
+	const char* position;
+	const char* end;
+};
+
+static uint16_t tileFromGid(uint32_t gid, uint32_t firstGid) {
+	gid &= TMX_GID_MASK;
+	// 0 stays empty, same as the Flare loader
+	if (gid < firstGid) return 0;
+	uint32_t tile = gid - firstGid;
+	return tile > 0xFFFF ? 0 : (uint16_t)tile;
+}
+
+static bool decodeCsv(const char* text, const char* end, TileLayer& layer, uint32_t firstGid) {
+	uint16_t* tiles = layer.Data();
+	size_t count = 0;
+	while (text < end) {
+		if (*text < '0' || *text > '9') { ++text; continue; }
+		uint32_t gid = 0;
+		while (text < end && *text >= '0' && *text <= '9') gid = gid * 10 + (*text++ - '0');
+		if (count == layer.Size()) return false;
+		tiles[count++] = tileFromGid(gid, firstGid);
+	}
+	return count == layer.Size();
+}
+
+static int base64Value(char c) {
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+static void decodeBase64(const char* text, const char* end, std::vector<unsigned char>& bytes) {
+	bytes.clear();
+	bytes.reserve((end - text) * 3 / 4);
+	uint32_t bits = 0;
+	int count = 0;
+	for (; text < end && *text != '='; ++text) {
+		int value = base64Value(*text);
+		// whitespace and line breaks between the characters
+		if (value < 0) continue;
+		bits = (bits << 6) | value;
+		if (++count == 4) {
+			bytes.push_back((unsigned char)(bits >> 16));
+			bytes.push_back((unsigned char)(bits >> 8));
+			bytes.push_back((unsigned char)bits);
+			bits = 0;
+			count = 0;
+		}
+	}
+	if (count == 3) {
+		bytes.push_back((unsigned char)(bits >> 10));
+		bytes.push_back((unsigned char)(bits >> 2));
+	}
+	else if (count == 2) {
+		bytes.push_back((unsigned char)(bits >> 4));
+	}
+}
+
+// Skips a gzip member header, returns the offset of the deflate stream or 0 if it isn't gzip
+static size_t gzipDataOffset(const std::vector<unsigned char>& bytes) {
+	if (bytes.size() < 18 || bytes[0] != 0x1f || bytes[1] != 0x8b || bytes[2] != 8) return 0;
+	unsigned char flags = bytes[3];
+	size_t offset = 10;
+	if (flags & 4) offset += 2 + (bytes[10] | (bytes[11] << 8));
+	if (flags & 8) { while (offset < bytes.size() && bytes[offset]) ++offset; ++offset; }
+	if (flags & 16) { while (offset < bytes.size() && bytes[offset]) ++offset; ++offset; }
+	if (flags & 2) offset += 2;
+	return offset < bytes.size() ? offset : 0;
+}
+
+static bool decodeBase64Layer(const char* text, const char* end, const std::string& compression, TileLayer& layer, uint32_t firstGid, std::vector<unsigned char>& scratch, std::vector<unsigned char>& inflated) {
+	decodeBase64(text, end, scratch);
+	const size_t size = layer.Size() * 4;
+	const std::vector<unsigned char>* gids = &scratch;
+	if (compression == "zlib" || compression == "gzip") {
+		inflated.resize(size + 1);
+		int length;
+		if (compression == "zlib") {
+			length = stbi_zlib_decode_buffer((char*)inflated.data(), (int)inflated.size(), (const char*)scratch.data(), (int)scratch.size());
+		}
+		else {
+			size_t offset = gzipDataOffset(scratch);
+			if (offset == 0) return false;
+			length = stbi_zlib_decode_noheader_buffer((char*)inflated.data(), (int)inflated.size(), (const char*)scratch.data() + offset, (int)(scratch.size() - offset));
+		}
+		if (length < 0) return false;
+		inflated.resize(length);
+		gids = &inflated;
+	}
+	else if (!compression.empty()) {
+		return false;
+	}
+	if (gids->size() != size) return false;
+	uint16_t* tiles = layer.Data();
+	const unsigned char* raw = gids->data();
+	for (size_t i = 0; i < layer.Size(); ++i, raw += 4) {
+		tiles[i] = tileFromGid(raw[0] | (raw[1] << 8) | (raw[2] << 16) | ((uint32_t)raw[3] << 24), firstGid);
+	}
+	return true;
+}
+
+static std::string siblingPath(const std::string& file, const std::string& relative) {
+	size_t slash = file.find_last_of("/\\");
+	return slash == std::string::npos ? relative : file.substr(0, slash + 1) + relative;
+}
+
+bool LoadTmxLevel(const std::string& tmxFile, GameState* state) {
+	MappedFile file;
+	if (!file.Open(tmxFile)) {
+		std::cout << "Unable to open level " << tmxFile << std::endl;
+		return false;
+	}
+	const char* text = (const char*)file.Data();
+	XmlReader reader(text, text + file.Size());
+	XmlTag tag;
+
+	int tileWidth = 0;
+	int tileHeight = 0;
+	uint32_t firstGid = 0;
+	bool haveLayer = false;
+	TileLayer* layer = nullptr;
+	// for data stored as one <tile gid=""/> per tile
+	size_t xmlTile = 0;
+	bool xmlTiles = false;
+	std::vector<unsigned char> scratch;
+	std::vector<unsigned char> inflated;
+	// placed once the whole map is read, see below
+	std::vector<std::pair<EntityStore::ENTITY_TYPE, std::array<float, 2>>> objects;
+
+	while (reader.Next(tag)) {
+		if (tag.closing) {
+			if (tag.name == "layer") layer = nullptr;
+			else if (tag.name == "data") xmlTiles = false;
+			continue;
+		}
+		if (tag.name == "map") {
+			tileWidth = tag.IntAttribute("tilewidth", 0);
+			tileHeight = tag.IntAttribute("tileheight", 0);
+			const std::string* orientation = tag.Attribute("orientation");
+			if (tileWidth <= 0 || tileHeight <= 0 || (orientation && *orientation != "orthogonal")) {
+				std::cout << tmxFile << ": only orthogonal maps with a tile size are supported" << std::endl;
+				return false;
+			}
+		}
+		else if (tag.name == "tileset") {
+			// every id is stored relative to the first tileset
+			if (firstGid != 0) continue;
+			firstGid = (uint32_t)tag.IntAttribute("firstgid", 1);
+			const std::string* source = tag.Attribute("source");
+			if (source && state->tileProperties == nullptr) {
+				std::string tsxFile = siblingPath(tmxFile, *source);
+				std::lock_guard<std::mutex> lock(tilesetLock);
+				TileProperties*& properties = tilesets[tsxFile];
+				if (properties == nullptr) {
+					properties = new TileProperties();
+					if (!properties->Load(tsxFile)) {
+						std::cout << tmxFile << ": unable to read tileset " << tsxFile << std::endl;
+						// not left behind empty, the next map that uses it tries again
+						delete properties;
+						tilesets.erase(tsxFile);
+						return false;
+					}
+				}
+				state->tileProperties = properties;
+			}
+		}
+		else if (tag.name == "layer") {
+			int width = tag.IntAttribute("width", 0);
+			int height = tag.IntAttribute("height", 0);
+			if (haveLayer) {
+				state->overlayLayers.emplace_back();
+				layer = &state->overlayLayers.back();
+			}
+			else {
+				layer = &state->tiles;
+				haveLayer = true;
+			}
+			layer->Resize(width, height);
+		}
+		else if (tag.name == "data" && layer) {
+			if (firstGid == 0) firstGid = 1;
+			const std::string* encoding = tag.Attribute("encoding");
+			const std::string* compression = tag.Attribute("compression");
+			if (encoding == nullptr) {
+				xmlTiles = !tag.selfClosing;
+				xmlTile = 0;
+				continue;
+			}
+			const char* data;
+			const char* dataEnd;
+			reader.FollowingText(data, dataEnd);
+			bool decoded = false;
+			if (*encoding == "csv") decoded = decodeCsv(data, dataEnd, *layer, firstGid);
+			else if (*encoding == "base64") decoded = decodeBase64Layer(data, dataEnd, compression ? *compression : "", *layer, firstGid, scratch, inflated);
+			if (!decoded) {
+				std::cout << tmxFile << ": unable to read " << *encoding << (compression ? " " + *compression : "") << " layer data for a "
+					<< layer->Width() << "x" << layer->Height() << " layer" << std::endl;
+				return false;
+			}
+		}
+		else if (tag.name == "tile" && xmlTiles && layer) {
+			if (xmlTile < layer->Size()) {
+				layer->Data()[xmlTile++] = tileFromGid((uint32_t)strtoul(tag.Attribute("gid") ? tag.Attribute("gid")->c_str() : "0", NULL, 10), firstGid);
+			}
+		}
+		else if (tag.name == "object") {
+			// Tiled 1.9 renamed type to class
+			const std::string* type = tag.Attribute("type");
+			if (type == nullptr) type = tag.Attribute("class");
+			EntityStore::ENTITY_TYPE entityType;
+			if (type == nullptr || !parseEntityType(*type, entityType)) {
+				std::cout << tmxFile << ": skipping object " << tag.IntAttribute("id", 0) << " of unknown type " << (type ? *type : "") << std::endl;
+				continue;
+			}
+			// whole tiles at one world unit each, like the Flare exports
+			int tileX = (int)(tag.FloatAttribute("x", 0.0f) / tileWidth);
+			int tileY = (int)(tag.FloatAttribute("y", 0.0f) / tileHeight);
+			objects.push_back({ entityType, { (float)tileX, (float)-tileY } });
+		}
+	}
+	if (!haveLayer) {
+		std::cout << tmxFile << ": no tile layer" << std::endl;
+		return false;
+	}
+	// the game drives entity 0 as the player, Tiled keeps objects in creation order
+	std::stable_partition(objects.begin(), objects.end(), [](const auto& object) { return object.first == EntityStore::ENTITY_PLAYER; });
+	state->entities.Reserve(objects.size());
+	for (const auto& object : objects) {
+		placeEntity(object.first, state, object.second[0], object.second[1]);
+	}
+	return true;
+}
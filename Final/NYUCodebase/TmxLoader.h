@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include "Game.h"
+
+// Reads a Tiled .tmx map into state in one pass over the file, without building a document tree.
+// Understands layer data stored as CSV, plain XML tiles, or base64 either raw or compressed with
+// zlib or gzip. The first tile layer becomes state->tiles and any further ones state->overlayLayers.
+// Object groups become entities by their type, in the same tile units the Flare exports use, and
+// an external .tsx tileset fills in state->tileProperties when the state has none yet.
+//
+// Tile ids are stored 0-based relative to the map's first tileset, like the Flare loader does.
+bool LoadTmxLevel(const std::string& tmxFile, GameState* state);
@@ -0,0 +1,72 @@
+#include "WorkerPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+WorkerPool::WorkerPool(unsigned int threads) : running(0), stopping(false) {
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i < threads; ++i) {
+		workers.emplace_back(&WorkerPool::Work, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers) worker.join();
+}
+
+void WorkerPool::Submit(const std::string& name, std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back({ name, std::move(job) });
+	}
+	wake.notify_one();
+}
+
+void WorkerPool::Wait() {
+	PROFILE_SCOPE("WorkerPool::Wait");
+	std::unique_lock<std::mutex> guard(lock);
+	finished.wait(guard, [this] { return jobs.empty() && running == 0; });
+}
+
+void WorkerPool::Work() {
+	std::unique_lock<std::mutex> guard(lock);
+	while (true) {
+		wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+		if (jobs.empty()) return;
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		++running;
+		guard.unlock();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_SCOPE("WorkerPool::Job");
+			job.run();
+		}
+		std::chrono::duration<double, std::milli> took = std::chrono::high_resolution_clock::now() - start;
+
+		guard.lock();
+		timings.push_back({ job.name, took.count() });
+		--running;
+		if (jobs.empty() && running == 0) finished.notify_all();
+	}
+}
+
+void WorkerPool::PrintTimings(double wallMilliseconds) {
+	std::lock_guard<std::mutex> guard(lock);
+	std::sort(timings.begin(), timings.end(), [](const Timing& a, const Timing& b) { return a.milliseconds > b.milliseconds; });
+	double total = 0.0;
+	for (const Timing& timing : timings) {
+		std::cout << "  " << timing.name << ": " << timing.milliseconds << " ms\n";
+		total += timing.milliseconds;
+	}
+	std::cout << timings.size() << " jobs on " << workers.size() << " threads in " << wallMilliseconds
+		<< " ms (" << total << " ms of work)" << std::endl;
+	timings.clear();
+}
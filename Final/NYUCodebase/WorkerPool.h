@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads working through a shared queue of named jobs, timing each one
+class WorkerPool {
+public:
+	// 0 starts one thread per core
+	WorkerPool(unsigned int threads = 0);
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Jobs run in any order and on any thread, they must not touch GL
+	void Submit(const std::string& name, std::function<void()> job);
+	// Blocks until every job submitted so far has finished
+	void Wait();
+
+	// Each job finished since the last call with how long it took, slowest first, and the total
+	// against the wall time they took together
+	void PrintTimings(double wallMilliseconds);
+
+	size_t Size() const { return workers.size(); }
+
+private:
+	struct Job {
+		std::string name;
+		std::function<void()> run;
+	};
+	struct Timing {
+		std::string name;
+		double milliseconds;
+	};
+	void Work();
+
+	std::vector<std::thread> workers;
+	std::deque<Job> jobs;
+	std::vector<Timing> timings;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	// jobs taken off the queue but not done yet
+	int running;
+	bool stopping;
+};
@@ -15,12 +15,31 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <cstring>
+#include <ctime>
+#include <set>
 #define STB_IMAGE_IMPLEMENTATION
-// 60 FPS (1.0f/60.0f) (update sixty times a second)
-#define FIXED_TIMESTEP 0.0166666f
+// images decode on several threads at once, stb_image keeps its failure message in one global
+#define STBI_NO_FAILURE_STRINGS
+// Render at most sixty frames a second, 0 for uncapped
+#define RENDER_RATE 60.0f
+// Frames slower than this get the flight recorder's history written to disk, -budget overrides it
+#define FRAME_BUDGET_MS 33.3f
+// Five seconds of history at sixty frames a second
+#define FLIGHT_RECORDER_FRAMES 300
 #include "stb_image.h"
+#include "Game.h"
+#include "InputScript.h"
 #include "Matrix.h"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "FrameScheduler.h"
+#include "TileMesh.h"
+#include "TextureCache.h"
+#include "Profiler.h"
+#include "FlightRecorder.h"
+#include "StateLoader.h"
+#include "WorkerPool.h"
 
 
 #ifdef _WINDOWS
@@ -30,6 +49,7 @@
 #endif
 
 SDL_Window* displayWindow;
+TextureCache textureCache;
 
 /**********************************************
  **********************************************
@@ -37,161 +57,51 @@ SDL_Window* displayWindow;
  **********************************************
  **********************************************/
 
-// SpriteSheet
-class SheetSprite {
+// Plays the simulation's sounds through SDL_mixer
+class MixerAudio : public AudioSink {
 public:
-	SheetSprite() {};
-	SheetSprite(unsigned int textureID, std::array<float, 4> coords, float size) :
-		textureID(textureID), u(coords[0]), v(coords[1]), width(coords[2]), height(coords[3]), size(size) {};
-	SheetSprite(unsigned int textureID, float u, float v, float width, float height, float size) : 
-		textureID(textureID), u(u), v(v), width(width), height(height), size(size) {}
-	void Draw(ShaderProgram& program) {
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		GLfloat texCoords[] = {
-			u, v + height,
-			u + width, v + height,
-			u + width, v,
-			u, v + height,
-			u + width, v,
-			u, v
-		};
-		float aspect = width / height;
-		float vertices[] = {
-			-0.5f * size * aspect, -0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, 0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, -0.5f * size ,
-			0.5f * size * aspect, -0.5f * size };
-		// draw our arrays
-		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+	// Call once the mixer is open, never at the same time as another mixer call
+	void Load(GAME_SOUND sound, const char* wavFile) {
+		chunks[sound] = Mix_LoadWAV(wavFile);
 	}
-	float size;
-	unsigned int textureID;
-	float u;
-	float v;
-	float width;
-	float height;
+	void Play(GAME_SOUND sound) override {
+		Mix_PlayChannel(-1, chunks[sound], 0);
+	}
+	Mix_Chunk* chunks[SOUND_COUNT];
 };
 
-// 3D Vector
-class Vector {
+MixerAudio audio;
+
+// Textures, tile meshes and sounds of the states as they load, freed again when they unload
+class GLResources : public StateResources {
 public:
-	Vector() : x(0.0f), y(0.0f), z(0.0f), b(1.0f) {}
-	Vector(const float x, const float y, const float z) : x(x), y(y), z(z), b(1.0f) {}
-	Vector(const float x, const float y, const float z, const float b) : x(x), y(y), z(z), b(b) {}
-	Vector& operator=(Vector const& rhs) {
-		x = rhs.x;
-		y = rhs.y;
-		z = rhs.z;
-		b = rhs.b;
-		return *this;
-	}
-	Vector operator+(Vector const& rhs) const {
-		Vector out(x + rhs.x, y + rhs.y, z + rhs.z, b + rhs.b);
-		return out;
-	}
-	Vector& operator+=(Vector const& rhs) {
-		x += rhs.x;
-		y += rhs.y;
-		z += rhs.z;
-		b += rhs.b;
-		return *this;
-	}
-	Vector operator*(const float num) const {
-		Vector out(x*num, y*num, z*num, b*num);
-		return out;
+	void DecodeTexture(const char* filePath) override {
+		textureCache.Decode(filePath);
 	}
-	Vector& operator*=(const float num) {
-		x *= num;
-		y *= num;
-		z *= num;
-		b *= num;
-		return *this;
+	unsigned int LoadTexture(const char* filePath) override {
+		return textureCache.Acquire(filePath);
 	}
-	float length() const {
-		return sqrt(x*x + y*y + z*z);
+	void ReleaseTexture(unsigned int texture) override {
+		textureCache.Release(texture);
 	}
-	Vector normalize() const {
-		const float length = this->length();
-		if(length) {
-			return Vector(x / length, y / length, z / length, b);
+	void Loaded(GameState* state) override {
+		// Tessellate each tile layer once, it never changes after loading
+		const TileSheet levelSheet = { 694.0f, 372.0f, 30, 3, 23, 21, 21 };
+		const TileSheet textSheet = { 512.0f, 512.0f, 16, 4, 32, 23, 23 };
+		state->tileMesh = new TileMesh();
+		std::vector<const TileLayer*> layers(1, &state->tiles);
+		for (const TileLayer& overlay : state->overlayLayers) layers.push_back(&overlay);
+		if (state->type == GameState::STATE_GAME) {
+			state->tileMesh->Build(layers, 1.0f, levelSheet);
 		}
-		return Vector();
-	}
-	float x, y, z, b;
-};
-
-// Basic Game Object
-class Entity {
-public:
-	enum ENTITY_TYPE { ENTITY_PLAYER, ENTITY_SNAIL, ENTITY_FLY, ENTITY_BOSS };
-	Entity(ENTITY_TYPE type, SheetSprite sprite, float x, float y) : position(x, y, 0.0f), size(1.0f, 1.0f, 1.0f), sprite(sprite), rotation(0.0f), type(type), health(1){
-		matrix.SetPosition(x, y, 0.0f);
-		alive = true;
-		if(type == ENTITY_BOSS)
-		{
-			health = 5;
+		else {
+			state->tileMesh->Build(layers, 0.5f, textSheet);
 		}
-	};
-	void Draw(ShaderProgram& program) {
-		//glBindTexture(GL_TEXTURE_2D, textureId);
-		float vertices[] = { position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2),
-			position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2), position.x - (size.x / 2), position.y + (size.y / 2) };
-		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
-		sprite.Draw(program);
-
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
-	}
-	void hit(){
-		health--;
-		if (health == 0) alive = false;
 	}
-	Matrix translate(const float x, const float y, const float z) {
-		matrix.Translate(x, y, z);
-		position += Vector(x, y, z);
-		return matrix;
+	void Unloading(GameState* state) override {
+		delete state->tileMesh;
+		state->tileMesh = nullptr;
 	}
-
-	Matrix matrix;
-	Vector position;
-	Vector size;
-	Vector velocity;
-	Vector acceleration;
-	SheetSprite sprite;
-	float rotation;
-	ENTITY_TYPE type;
-	bool alive;
-	/*
-	 *  contact indices clockwise:
-	 *		0
-	 *	3  obj	1
-	 *		2
-	 */
-	bool contact[4];
-	int health;
-	std::vector<SheetSprite> frames;
-	int frame = 0;
-	int lastFrame = 0;
-};
-
-// Game States
-class GameState {
-public:
-	enum STATE_TYPE { STATE_MENU, STATE_GAME, STATE_WIN, STATE_LOSE };
-	GameState(STATE_TYPE type) : type(type) {}
-	std::vector<Entity*> entities;
-	int** levelData;
-	int levelWidth;
-	int levelHeight;
-	std::map<int, bool> solids;
-	STATE_TYPE type;
-	std::map<int, SheetSprite> sprites;
-	std::vector<Mix_Chunk*> sounds;
 };
 
 /**********************************************
@@ -201,29 +111,15 @@ public:
  **********************************************/
 
 
-GLuint LoadTexture(const char *filePath);
-
-float randf(float a, float b);
-
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height);
-
-bool readHeader(std::ifstream &stream, GameState* state);
+float millisecondsSince(Uint64 start);
 
-bool readLayerData(std::ifstream &stream, GameState* state);
+void DrawEntity(SpriteBatch& batch, const EntityStore& entities, size_t ent, float alpha);
 
-bool readEntityData(std::ifstream &stream, GameState* state, int TILE_SIZE);
+ShaderProgram Setup(WorkerPool& pool, const StateLoader& states);
 
-void placeEntity(std::string type, GameState* state, float placeX, float placeY);
+InputState PollInput(SDL_Event& event);
 
-ShaderProgram Setup();
-
-std::vector<GameState*> Instantiate();
-
-void ProcessEvents(SDL_Event& event, bool& done, GameState*& currentState, std::vector<GameState*>& states);
-
-void Update(GameState* state, float elapsed, float ticks);
-
-void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, GameState* state);
+void Render(const Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state, float alpha);
 
 void Cleanup();
 
@@ -235,45 +131,119 @@ void Cleanup();
 
 int main(int argc, char *argv[])
 {
-	ShaderProgram program = Setup();
+	// -record <file> saves the session's input and seed, -replay <file> plays one back
+	// through the same fixed step as fast as it can be drawn, -unload frees each state on leaving it
+	const char* recordFile = nullptr;
+	const char* replayFile = nullptr;
+	float budgetMs = FRAME_BUDGET_MS;
+	bool unloadStates = false;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-unload") == 0) unloadStates = true;
+		else if (i + 1 == argc) break;
+		else if (strcmp(argv[i], "-record") == 0) recordFile = argv[++i];
+		else if (strcmp(argv[i], "-replay") == 0) replayFile = argv[++i];
+		else if (strcmp(argv[i], "-budget") == 0) budgetMs = (float)atof(argv[++i]);
+	}
+	InputScript recording;
+	InputScript replay;
+	if (replayFile && !replay.Load(replayFile)) {
+		return 1;
+	}
+
+	// Read the manifest first so the menu can load while the window opens
+	GLResources resources;
+	StateLoader states(resources);
+	states.unloadOnLeave = unloadStates;
+	if (!states.LoadManifest("States.txt")) {
+		return 1;
+	}
+	states.Prefetch(0);
+	WorkerPool pool;
+	ShaderProgram program = Setup(pool, states);
 
 	// Setup Projection Matrix
-	Matrix projectionMatrix;
-	projectionMatrix.SetOrthoProjection(-7.1f, 7.1f, -4.0f, 4.0f, -1.0f, 1.0f);
+	static constexpr Matrix projectionMatrix = Matrix::OrthoProjection(-7.1f, 7.1f, -4.0f, 4.0f, -1.0f, 1.0f);
 	Matrix modelMatrix;
 	Matrix viewMatrix;
+	SpriteBatch batch;
 
-	float lastFrameTicks = 0.0f;
+	recording.seed = replayFile ? replay.seed : (uint32_t)time(NULL);
+	SeedRandom(recording.seed);
 
-	//Instantiate Objects, Textures, and States
-	
-	std::vector<GameState*> states = Instantiate();
+	// States load as the game first reaches them, only the menu is needed to start
+	GameState* currentState = states.Enter(0);
+	if (currentState == nullptr) {
+		return 1;
+	}
+	textureCache.PrintStats();
 
-	GameState* currentState = states[0];
 	SDL_Event event;
 	bool done = false;
-	float accumulator = 0.0f;
+	FrameScheduler scheduler(1.0f / FIXED_TIMESTEP, replayFile ? 0.0f : RENDER_RATE);
+	// a replay at full speed would only be noise
+	AudioSink silence;
+	AudioSink& sounds = replayFile ? silence : audio;
+	FlightRecorder flightRecorder(FLIGHT_RECORDER_FRAMES, budgetMs);
+	InputState input;
+	unsigned long step = 0;
 	while (!done) {
-		ProcessEvents(event, done, currentState, states);
-
-		float ticks = static_cast<float>(SDL_GetTicks()) / 1000.0f;
-		float elapsed = ticks - lastFrameTicks;
-		lastFrameTicks = ticks;
-		// get elapsed time
-		elapsed += accumulator;
-		if (elapsed < FIXED_TIMESTEP) {
-			accumulator = elapsed;
-			continue;
-		}
-		while (elapsed >= FIXED_TIMESTEP) {
-			Update(currentState, FIXED_TIMESTEP, ticks);
-			elapsed -= FIXED_TIMESTEP;
+		// sleeps instead of spinning until the next frame is due
+		float elapsed = scheduler.WaitForNextFrame();
+		PROFILE_SCOPE("Frame");
+		FrameRecord& record = flightRecorder.Next();
+		record.elapsedMs = elapsed * 1000.0f;
+		Uint64 mark = SDL_GetPerformanceCounter();
+		// presses wait here until a step takes them
+		input.Merge(PollInput(event));
+		record.input = input;
+		record.inputMs = millisecondsSince(mark);
+
+		mark = SDL_GetPerformanceCounter();
+		// uploads whatever the loader thread has parsed since last frame
+		states.Poll();
+		// bounded so a long hitch can't turn into an ever growing catch-up
+		int steps = scheduler.Accumulate(elapsed);
+		if (replayFile) {
+			// one recorded step per frame, unpaced
+			steps = 1;
+			if (input.quit || replay.Finished()) done = true;
+		}
+		for (int i = 0; i < steps && !done; ++i) {
+			InputState stepInput = replayFile ? replay.Next() : input;
+			input.ClearPresses();
+			if (recordFile) recording.Record(stepInput);
+			Step(stepInput, step++, done, currentState, states, sounds);
+		}
+		record.steps = steps;
+		record.accumulator = scheduler.Alpha() * scheduler.UpdateStep();
+		record.updateMs = millisecondsSince(mark);
+
+		mark = SDL_GetPerformanceCounter();
+		unsigned long skippedBefore = ShaderProgram::skippedCalls;
+		// draw between the last two steps by however far into the next step we are
+		Render(projectionMatrix, modelMatrix, viewMatrix, program, batch, currentState, replayFile ? 1.0f : scheduler.Alpha());
+		record.renderMs = millisecondsSince(mark);
+		record.entities = (int)currentState->entities.Size();
+		record.drawCalls = batch.drawCalls + (currentState->tileMesh->vertexCount > 0 ? 1 : 0);
+		record.sprites = batch.sprites;
+		record.skippedGLCalls = (int)(ShaderProgram::skippedCalls - skippedBefore);
+
+		mark = SDL_GetPerformanceCounter();
+		{
+			PROFILE_SCOPE("SwapWindow");
+			SDL_GL_SwapWindow(displayWindow);
 		}
-		accumulator = elapsed;
-		Render(projectionMatrix, modelMatrix, viewMatrix, program, currentState);
+		record.swapMs = millisecondsSince(mark);
+		flightRecorder.Commit(record);
 	}
 
+	if (recordFile) {
+		recording.Save(recordFile);
+		std::cout << "Recorded " << step << " steps to " << recordFile << std::endl;
+	}
 
+	ShaderProgram::PrintStats();
+	states.UnloadAll();
 	Cleanup();
 	return 0;
 }
@@ -284,165 +254,14 @@ int main(int argc, char *argv[])
  **********************************************
  **********************************************/
 
-GLuint LoadTexture(const char *filePath) {
-	int w, h, comp;
-	unsigned char* image = stbi_load(filePath, &w, &h, &comp, STBI_rgb_alpha);
-	if (image == NULL) {
-		std::cout << "Unable to load image. Make sure the path is correct\n";
-		assert(false);
-	}
-	GLuint retTexture;
-	glGenTextures(1, &retTexture);
-	glBindTexture(GL_TEXTURE_2D, retTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-	// LINEAR
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// NEAREST
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	stbi_image_free(image);
-	return retTexture;
+float millisecondsSince(Uint64 start) {
+	return (SDL_GetPerformanceCounter() - start) * 1000.0f / SDL_GetPerformanceFrequency();
 }
 
-bool isCollidingRect(Entity* r1, Entity* r2){
-	// Is r1 bottom > r2 top?
-	if (r1->position.y - r1->size.y / 2 > r2->position.y + r2->size.y / 2) return false;
-	// Is r1 top < r2 bottom?
-	if (r1->position.y + r1->size.y / 2 < r2->position.y - r2->size.y / 2) return false;
-	// Is r1 left > r2 right?
-	if (r1->position.x - r1->size.y / 2 > r2->position.x + r2->size.y / 2) return false;
-	// Is r1 right < r2 left?
-	if (r1->position.x + r1->size.y / 2 < r2->position.x - r2->size.y / 2) return false;
-
-	return true;
-}
-
-bool isCollidingRect(Entity* r1, Vector position, Vector size) {
-	// Is r1 bottom > r2 top?
-	if (r1->position.y - r1->size.y / 2 > position.y + size.y / 2) return false;
-	// Is r1 top < r2 bottom?
-	if (r1->position.y + r1->size.y / 2 < position.y - size.y / 2) return false;
-	// Is r1 left > r2 right?
-	if (r1->position.x - r1->size.y / 2 > position.x + size.y / 2) return false;
-	// Is r1 right < r2 left?
-	if (r1->position.x + r1->size.y / 2 < position.x - size.y / 2) return false;
-
-	return true;
-}
-
-float lerp(float v0, float v1, float t) {
-	return (1.0 - t)*v0 + t*v1;
-}
-
-float randf(float a, float b) {
-	float random = ((float)rand()) / (float)RAND_MAX;
-	float diff = b - a;
-	float r = random * diff;
-	return a + r;
-}
-
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height)
-{
-	std::array<float, 4> out;
-	out[0] = float(xPx) / sheetWidth;
-	out[1] = float(yPx) / sheetHeight;
-	out[2] = float(width) / sheetWidth;
-	out[3] = float(height) / sheetHeight;
-	return out;
-}
-
-bool readHeader(std::ifstream &stream, GameState* state) {
-	std::string line;
-	state->levelWidth = -1;
-	state->levelHeight = -1;
-	while (getline(stream, line)) {
-		if (line == "") { break; }
-		std::istringstream sStream(line);
-		std::string key, value;
-		getline(sStream, key, '=');
-		getline(sStream, value);
-		if (key == "width") {
-			state->levelWidth = atoi(value.c_str());
-		}
-		else if (key == "height") {
-			state->levelHeight = atoi(value.c_str());
-		}
-	}
-	if (state->levelWidth == -1 || state->levelHeight == -1) {
-		return false;
-	}
-	else { // allocate our map data
-		state->levelData = new int*[state->levelHeight];
-		for (int i = 0; i < state->levelHeight; ++i) {
-			state->levelData[i] = new int[state->levelWidth];
-		}
-		return true;
-	}
-}
-
-bool readLayerData(std::ifstream &stream, GameState* state) {
-	std::string line;
-	while (getline(stream, line)) {
-		if (line == "") { break; }
-		std::istringstream sStream(line);
-		std::string key, value;
-		getline(sStream, key, '=');
-		getline(sStream, value);
-		if (key == "data") {
-			for (int y = 0; y < state->levelHeight; y++) {
-				getline(stream, line);
-				std::istringstream lineStream(line);
-				std::string tile;
-				for (int x = 0; x < state->levelWidth; x++) {
-					getline(lineStream, tile, ',');
-					int val = atoi(tile.c_str());
-					if (val > 0) {
-						// be careful, the tiles in this format are indexed from 1 not 0
-						state->levelData[y][x] = val - 1;
-					}
-					else {
-						state->levelData[y][x] = 0;
-					}
-				}
-			}
-		}
-	}
-	return true;
-}
-
-bool readEntityData(std::ifstream &stream, GameState* state, int TILE_SIZE) {
-	std::string line;
-	std::string type;
-	while (getline(stream, line)) {
-		if (line == "") { break; }
-		std::istringstream sStream(line);
-		std::string key, value;
-		getline(sStream, key, '=');
-		getline(sStream, value);
-		if (key == "type") {
-			type = value;
-		}
-		else if (key == "location") {
-			std::istringstream lineStream(value);
-			std::string xPosition, yPosition;
-			getline(lineStream, xPosition, ',');
-			getline(lineStream, yPosition, ',');
-			float placeX = atoi(xPosition.c_str())*TILE_SIZE;
-			float placeY = atoi(yPosition.c_str())*-TILE_SIZE;
-			placeEntity(type, state, placeX, placeY);
-		}
-	}
-	return true;
-}
-
-void placeEntity(std::string type, GameState* state, float placeX, float placeY) {
-	Entity::ENTITY_TYPE entityType;
-	if (type == "Player") entityType = Entity::ENTITY_PLAYER;
-	else if (type == "Snail") entityType = Entity::ENTITY_SNAIL;
-	else if (type == "Fly") entityType = Entity::ENTITY_FLY;
-	else if (type == "Boss") entityType = Entity::ENTITY_BOSS;
-	state->entities.push_back(new Entity(entityType, state->sprites[entityType], placeX, placeY));
+void DrawEntity(SpriteBatch& batch, const EntityStore& entities, size_t ent, float alpha) {
+	Vector drawn = entities.Interpolated(ent, alpha);
+	const SheetSprite& sprite = entities.detail[ent].sprite;
+	batch.Draw(sprite.textureID, drawn.x, drawn.y, entities.width[ent], entities.height[ent], sprite.u, sprite.v, sprite.width, sprite.height);
 }
 
 
@@ -453,9 +272,27 @@ void placeEntity(std::string type, GameState* state, float placeX, float placeY)
  **********************************************
  **********************************************/
 
-ShaderProgram Setup() {
-	// Setup SDL
+ShaderProgram Setup(WorkerPool& pool, const StateLoader& states) {
+	Uint64 start = SDL_GetPerformanceCounter();
+	// Setup SDL, the mixer first so the sounds can decode while the window opens
 	SDL_Init(SDL_INIT_VIDEO);
+	Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
+
+	// Decode on the workers, nothing that touches GL
+	Mix_Music* music = NULL;
+	// SDL_mixer's loaders share decoder state, so the sounds load one after another in a single job
+	pool.Submit("sounds", [&music] {
+		music = Mix_LoadMUS("music.mp3");
+		audio.Load(SOUND_JUMP, "jump.wav");
+		audio.Load(SOUND_KILL, "kill.wav");
+	});
+	// every image in the manifest, uploaded when a state first needs it
+	std::set<std::string> textures;
+	for (size_t i = 0; i < states.Count(); ++i) textures.insert(states.Entry(i).texture);
+	for (const std::string& texture : textures) {
+		pool.Submit(texture, [texture] { textureCache.Decode(texture); });
+	}
+
 	displayWindow = SDL_CreateWindow("My Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 360, SDL_WINDOW_OPENGL);
 	SDL_GLContext context = SDL_GL_CreateContext(displayWindow);
 	SDL_GL_MakeCurrent(displayWindow, context);
@@ -476,359 +313,49 @@ ShaderProgram Setup() {
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendColor(94.0f / 256, 129.0f / 256, 162.0f / 256, 0.0f);
 
-	// Setup SDL_Mixer
-	Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
-	Mix_Music* music;
-	music = Mix_LoadMUS("music.mp3");
+	pool.Wait();
+	std::cout << "Assets:\n";
+	pool.PrintTimings(millisecondsSince(start));
 	Mix_Volume(2, 100);
 	Mix_PlayMusic(music, -1);
 
 	return *program;
 }
 
-std::vector<GameState*> Instantiate() {
-	std::vector<GameState*> states;
-	states.push_back(new GameState(GameState::STATE_MENU));
-	states.push_back(new GameState(GameState::STATE_GAME));
-	states.push_back(new GameState(GameState::STATE_GAME));
-	states.push_back(new GameState(GameState::STATE_GAME));
-	states.push_back(new GameState(GameState::STATE_WIN));
-	states.push_back(new GameState(GameState::STATE_LOSE));
-
-	for (int i = 1; i < 4; ++i) {
-		states[i]->sprites[Entity::ENTITY_PLAYER] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 19 + 19 * 2, 3 + 21 * 0, 21, 21), 1.0f);
-		states[i]->sprites[Entity::ENTITY_SNAIL] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 14 + 2 * 14, 3 + 21 * 15 + 2 * 15, 21, 21), 1.0f);
-		states[i]->sprites[Entity::ENTITY_FLY] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 13 + 2 * 13, 3 + 21 * 14 + 2 * 14, 21, 21), 1.0f);
-		states[i]->sprites[Entity::ENTITY_BOSS] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 19 + 19 * 2, 3 + 21 * 2 + 2 * 2, 21, 21), 1.0f);
-		states[i]->solids[124 - 1] = true;
-		states[i]->solids[127 - 1] = true;
-		states[i]->solids[126 - 1] = true;
-		states[i]->solids[156 - 1] = true;
-		states[i]->solids[125 - 1] = true;
-		states[i]->solids[159 - 1] = true;
-		states[i]->solids[160 - 1] = true;
-		states[i]->solids[71 - 1] = true;
-		states[i]->solids[130 - 1] = true;
-		states[i]->solids[279 - 1] = true;
-		states[i]->solids[244 - 1] = true;
-		states[i]->solids[246 - 1] = true;
-		states[i]->solids[273 - 1] = true;
-		states[i]->solids[274 - 1] = true;
-		states[i]->solids[276 - 1] = true;
-		states[i]->solids[278 - 1] = true;
-
-		// Load Sounds
-		states[i]->sounds.emplace_back(Mix_LoadWAV("jump.wav"));
-		states[i]->sounds.emplace_back(Mix_LoadWAV("kill.wav"));
-	}
-
-	// Load background and textures
-	std::string levelFile = ("MapFlare.txt");
-
-	int mapWidth = 40;
-	int mapHeight = 15;
-	std::ifstream infile(levelFile);
-	std::string line;
-	while (getline(infile, line)) {
-		if (line == "[header]") {
-			if (!readHeader(infile, states[1])) {
-				assert(false);
-			}
-		}
-		else if (line == "[layer]") {
-			readLayerData(infile, states[1]);
-		}
-		else if (line == "[Object Layer]") {
-			readEntityData(infile, states[1], 1);
-		}
-	}
-
-	infile.close();
-	levelFile = "MapFlare2.txt";
-
-	infile.open(levelFile);
-	while (getline(infile, line)) {
-		if (line == "[header]") {
-			if (!readHeader(infile, states[2])) {
-				assert(false);
-			}
-		}
-		else if (line == "[layer]") {
-			readLayerData(infile, states[2]);
-		}
-		else if (line == "[Object Layer]") {
-			readEntityData(infile, states[2], 1);
-		}
-	}
-	infile.close();
-	levelFile = "MapFlare3.txt";
-
-	infile.open(levelFile);
-	while (getline(infile, line)) {
-		if (line == "[header]") {
-			if (!readHeader(infile, states[3])) {
-				assert(false);
-			}
-		}
-		else if (line == "[layer]") {
-			readLayerData(infile, states[3]);
-		}
-		else if (line == "[Object Layer]") {
-			readEntityData(infile, states[3], 1);
-		}
-	}
-	infile.close();
-	levelFile = "MenuFlare.txt";
-
-	infile.open(levelFile);
-	while (getline(infile, line)) {
-		if (line == "[header]") {
-			if (!readHeader(infile, states[0])) {
-				assert(false);
-			}
-		}
-		else if (line == "[layer]") {
-			readLayerData(infile, states[0]);
-		}
-		else if (line == "[Object Layer]") {
-			readEntityData(infile, states[0], 1);
-		}
-	}
-
-	infile.close();
-	levelFile = "LoseFlare.txt";
-
-	infile.open(levelFile);
-	while (getline(infile, line)) {
-		if (line == "[header]") {
-			if (!readHeader(infile, states[4])) {
-				assert(false);
-			}
-		}
-		else if (line == "[layer]") {
-			readLayerData(infile, states[4]);
-		}
-		else if (line == "[Object Layer]") {
-			readEntityData(infile, states[4], 1);
-		}
-	}
-	infile.close();
-
-	levelFile = "WinFlare.txt";
-
-	infile.open(levelFile);
-	while (getline(infile, line)) {
-		if (line == "[header]") {
-			if (!readHeader(infile, states[5])) {
-				assert(false);
-			}
-		}
-		else if (line == "[layer]") {
-			readLayerData(infile, states[5]);
-		}
-		else if (line == "[Object Layer]") {
-			readEntityData(infile, states[5], 1);
-		}
-	}
-	infile.close();
-
-	for(int i = 1; i < 4; ++i){
-		states[i]->entities[0]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 19 + 20 * 2, 3 + 21 * 0, 21, 21), 1.0f));
-		states[i]->entities[0]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 28 + 28 * 2, 3 + 21 * 0, 21, 21), 1.0f));
-		states[i]->entities[0]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 29 + 29 * 2, 3 + 21 * 0, 21, 21), 1.0f));
-		if(states[i]->entities[1]->type == Entity::ENTITY_FLY) {
-			for (int j = 1; j < 4; ++j) {
-				states[i]->entities[j]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 13 + 2 * 13, 3 + 21 * 14 + 2 * 14, 21, 21), 1.0f));
-				states[i]->entities[j]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 14 + 2 * 13, 3 + 21 * 14 + 2 * 14, 21, 21), 1.0f));
-			}
-		}
-		else if(states[i]->entities[1]->type == Entity::ENTITY_BOSS){
-			states[i]->entities[1]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 28 + 28 * 2, 3 + 21 * 2 + 2 * 2, 21, 21), 1.0f));
-			states[i]->entities[1]->frames.push_back(SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 29 + 29 * 2, 3 + 21 * 2 + 2 * 2, 21, 21), 1.0f));
-
-		}
-	}
-
-
-	return states;
-}
-
-void ProcessEvents(SDL_Event & event, bool& done, GameState*& currentState, std::vector<GameState*>& states){
+InputState PollInput(SDL_Event& event) {
+	PROFILE_SCOPE("PollInput");
+	InputState input;
 	// SDL Event Loop
-	switch(currentState->type)
-	{
-	case GameState::STATE_TYPE::STATE_MENU:
-		while (SDL_PollEvent(&event)) {
-			// Quit or Close Event
-			if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
-				done = true;
-			}
-			if (event.type == SDL_KEYDOWN) {
-				if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
-					done = true;
-				}
-				currentState = states[1];
+	while (SDL_PollEvent(&event)) {
+		// Quit or Close Event
+		if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
+			input.quit = true;
+		}
+		if (event.type == SDL_KEYDOWN) {
+			// F9 saves what the profiler has so far, it isn't game input
+			if (event.key.keysym.scancode == SDL_SCANCODE_F9) {
+				PROFILE_WRITE("trace.json");
+				continue;
 			}
-		}
-		break;
-	case GameState::STATE_TYPE::STATE_GAME: {
-		// Win or Lose
-		if (currentState->entities[0]->alive == false) currentState = states[4];
-		else if (currentState->entities[1]->alive == false && currentState->entities[1]->type == Entity::ENTITY_BOSS) currentState = states[5];
-		else {
-			while (SDL_PollEvent(&event)) {
-				// Quit or Close Event
-				if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
-					done = true;
-				}
-				if (event.type == SDL_KEYDOWN) {
-					if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
-						done = true;
-					}
-					else if (currentState->type == GameState::STATE_GAME && currentState->entities[0]->alive) {
-						if (event.key.keysym.scancode == SDL_SCANCODE_SPACE && currentState->entities[0]->contact[2]) {
-							Mix_PlayChannel(-1, currentState->sounds[0], 0);
-							currentState->entities[0]->velocity.y = 6;
-						}
-					}
-					if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
-						done = true;
-					}
-				}
-			}
-
-			// Keyboard Polling
-			const Uint8* keys = SDL_GetKeyboardState(NULL);
-			if (keys[SDL_SCANCODE_RIGHT] && currentState->entities[0]->position.x + currentState->entities[0]->size.x / 2 < 40) {
-				currentState->entities[0]->velocity.x = 3;
-				if (currentState->entities[0]->frame == 0 || currentState->entities[0]->frame == 1) { ++currentState->entities[0]->frame;  currentState->entities[0]->sprite = currentState->entities[0]->frames[2]; }
-				else if (currentState->entities[0]->frame == 2) {
-					--currentState->entities[0]->frame;
-					currentState->entities[0]->sprite = currentState->entities[0]->frames[1];
-				}
-			}
-			if (keys[SDL_SCANCODE_LEFT] && currentState->entities[0]->position.x - currentState->entities[0]->size.x / 2 > 0.0f) {
-				currentState->entities[0]->velocity.x = -3;
-				if (currentState->entities[0]->frame == 0 || currentState->entities[0]->frame == 1) { ++currentState->entities[0]->frame;  currentState->entities[0]->sprite = currentState->entities[0]->frames[2]; }
-				else if (currentState->entities[0]->frame == 2) {
-					--currentState->entities[0]->frame;
-					currentState->entities[0]->sprite = currentState->entities[0]->frames[1];
-				}
+			input.keyPressed = true;
+			if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
+				input.quit = true;
 			}
-			if ((currentState == states[1] || currentState == states[2]) && currentState->entities[0]->position.x + currentState->entities[0]->size.x / 2 >= 40) {
-				if (currentState == states[1]) currentState = states[2];
-				else if (currentState == states[2]) currentState = states[3];
+			else if (event.key.keysym.scancode == SDL_SCANCODE_SPACE) {
+				input.jump = true;
 			}
 		}
-		break;
-	}
-	case GameState::STATE_TYPE::STATE_LOSE: {}
-	case GameState::STATE_TYPE::STATE_WIN: {
-		while (SDL_PollEvent(&event)) {
-			// Quit or Close Event
-			if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
-				done = true;
-			}
-			if (event.type == SDL_KEYDOWN) {
-				if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
-					done = true;
-				}
-			}
-		}
-		break;
-	}
 	}
 
+	// Keyboard Polling
+	const Uint8* keys = SDL_GetKeyboardState(NULL);
+	input.left = keys[SDL_SCANCODE_LEFT] != 0;
+	input.right = keys[SDL_SCANCODE_RIGHT] != 0;
+	return input;
 }
-void Update(GameState* state, float elapsed, float ticks) {
-	switch(state->type) {
-	case GameState::STATE_TYPE::STATE_GAME:
-		if (state->entities[0]->position.y < -15) state->entities[0]->hit();
-		if(state->entities[1]->type == Entity::ENTITY_SNAIL) state->entities[1]->velocity.x = -1;
-		// Boss Behavior
-		else if(state->entities[1]->type == Entity::ENTITY_BOSS) {
-			Entity* player = state->entities[0];
-			Entity* boss = state->entities[1];
-			if (player->position.x - randf(2.0f, 6.0f) > boss->position.x) boss->velocity.x = 3.0f + (5-boss->health)/2;
-			else if (player->position.x + randf(2.0f, 6.0f) < boss->position.x) boss->velocity.x = -3.0f - (5-boss->health)/2;
-			if (boss->health < 4 && boss->position.x < player->position.x + 1 && boss->position.x > player->position.x - 1 && boss->contact[2] && player->position.y > boss->position.y+1.5f) {
-				if (boss->position.x > 7.5f) boss->velocity.x = -8.0f;
-				else boss->velocity.x = 8.0f;
-			}
-			if (rand() % 100 == 1 && boss->position.y < 2.0f && (boss->contact[2] || boss->health < 3)) boss->velocity.y = 4.0f + (5-boss->health)/2;
-			if (boss->frame == 0 && boss->lastFrame + 0.9f < ticks && boss->contact[2]) {
-				boss->frame++;
-				boss->sprite = boss->frames[boss->frame];
-				boss->lastFrame = ticks;
-			}
-			else if (boss->frame == 1 && boss->lastFrame + 0.9f < ticks && boss->contact[2]) {
-				boss->frame--;
-				boss->sprite = boss->frames[boss->frame];
-				boss->lastFrame = ticks;
-			}
-		}
-		// All Collision Checking
-		for (Entity*& ent : state->entities) {
-			ent->acceleration.y = -6.0f;
-			if (ent->alive) {
-				if (ent->type == Entity::ENTITY_FLY) {
-					ent->position.y += sin(ticks)*elapsed;
-					if(ent->frame == 0 && ent->lastFrame + 1.0f < ticks) {
-						ent->frame++;
-						ent->sprite = ent->frames[ent->frame];
-						ent->lastFrame = ticks;
-					}
-					else if(ent->frame == 1 && ent->lastFrame + 1.0f < ticks){
-						ent->frame--;
-						ent->sprite = ent->frames[ent->frame];
-						ent->lastFrame = ticks;
-					}
-				}
-				else {
-					if(ent->type != Entity::ENTITY_BOSS) ent->velocity.x = lerp(ent->velocity.x, 0.0f, elapsed);
-					ent->velocity.x += ent->acceleration.x*elapsed;
-					ent->position += ent->velocity * elapsed;
-
-					ent->velocity.y += ent->acceleration.y * elapsed;
-				}
-				ent->contact[2] = false;
-				for (int y = 0; y < state->levelHeight; ++y) {
-					for (int x = 0; x < state->levelWidth; ++x) {
-						if (state->solids[state->levelData[y][x]]) {
-							Vector pos(x + 0.5f, -y - 0.5f, 0.0f);
-							Vector size(1.0f, 1.0f, 0.0f);
-							if (isCollidingRect(ent, pos, size)) {
-								if (ent->position.y >= pos.y) { ent->position.y += ((pos.y + size.y / 2) - (ent->position.y - ent->size.y / 2)); ent->contact[2] = true; }
-								else if (ent->position.y < pos.y) ent->position.y -= ((ent->position.y + ent->size.y / 2) - (pos.y - size.y / 2)) + 0.00001f;
-								//if(ent->position.x > pos.x) ent->position.x += ((pos.x + size.x / 2) - (ent->position.x - ent->size.x / 2));
-								//else if (ent->position.x < pos.x) ent->position.x -= ((ent->position.y + ent->size.x / 2) - (pos.x - size.x / 2));
-								ent->velocity.y = 0;
-								if (state->levelData[y][x] == 70) ent->alive = false;
-							}
-						}
-					}
-				}
-				
-				Entity* player = state->entities[0];
-				if (ent != state->entities[0] && isCollidingRect(player, ent)) {
-					if (player->position.y - (player->size.y / 2) >= ent->position.y + (ent->size.y / 2) - 0.2f) {
-						ent->hit();
-						player->velocity.y = 6;
-					}
-					else {
-						player->hit();
-					}
-
-					Mix_PlayChannel(-1, state->sounds[1], 0);
-				}
-			}
-		}
-	}
-}
-
-
 
-void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, GameState* state) {
+void Render(const Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state, float alpha) {
+	PROFILE_SCOPE("Render");
 	glClear(GL_COLOR_BUFFER_BIT);
 	modelMatrix.Identity();
 	viewMatrix.Identity();
@@ -836,78 +363,29 @@ void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, S
 	switch(state->type)
 	{
 	case GameState::STATE_TYPE::STATE_GAME: {
-		if(state->entities[1]->type == Entity::ENTITY_BOSS)
+		Vector player = state->entities.Interpolated(0, alpha);
+		if(state->entities.type[1] == EntityStore::ENTITY_BOSS)
 		{
-			if (state->entities[0]->position.x < 7.1) viewMatrix.Translate(-7.1f, 0.0f, 0.0f);
-			else if (state->entities[0]->position.x > 15 - 7.1) viewMatrix.Translate(-(15 - 7.1), 0.0f, 0.0f);
-			else viewMatrix.Translate(-state->entities[0]->position.x, 0.0f, 0.0f);
-			if (state->entities[0]->position.y < -11.0) viewMatrix.Translate(0.0f, 11.0f, 0.0f);
-			else viewMatrix.Translate(0.0f, -state->entities[0]->position.y, 0.0f);
+			if (player.x < 7.1) viewMatrix.Translate(-7.1f, 0.0f, 0.0f);
+			else if (player.x > 15 - 7.1) viewMatrix.Translate(-(15 - 7.1), 0.0f, 0.0f);
+			else viewMatrix.Translate(-player.x, 0.0f, 0.0f);
+			if (player.y < -11.0) viewMatrix.Translate(0.0f, 11.0f, 0.0f);
+			else viewMatrix.Translate(0.0f, -player.y, 0.0f);
 		}
 		else {
-			if (state->entities[0]->position.x < 7.1) viewMatrix.Translate(-7.1f, 0.0f, 0.0f);
-			else if (state->entities[0]->position.x > 40 - 7.1) viewMatrix.Translate(-(40 - 7.1), 0.0f, 0.0f);
-			else viewMatrix.Translate(-state->entities[0]->position.x, 0.0f, 0.0f);
-			if (state->entities[0]->position.y < -9.0) viewMatrix.Translate(0.0f, 9.0f, 0.0f);
-			else viewMatrix.Translate(0.0f, -state->entities[0]->position.y, 0.0f);
+			if (player.x < 7.1) viewMatrix.Translate(-7.1f, 0.0f, 0.0f);
+			else if (player.x > 40 - 7.1) viewMatrix.Translate(-(40 - 7.1), 0.0f, 0.0f);
+			else viewMatrix.Translate(-player.x, 0.0f, 0.0f);
+			if (player.y < -9.0) viewMatrix.Translate(0.0f, 9.0f, 0.0f);
+			else viewMatrix.Translate(0.0f, -player.y, 0.0f);
 		}
 
 		//viewMatrix.Translate(0.0f, 0.1f, 0.0f);
 		program.SetModelviewMatrix(modelMatrix*viewMatrix);
 		program.SetProjectionMatrix(projectionMatrix);
-		glUseProgram(program.programID);
-		std::vector<float> vertexData;
-		std::vector<float> texCoordData;
-		float TILE_SIZE = 1.0f;
-		int SPRITE_COUNT_X = 30;
-		int SPRITE_COUNT_Y = 16;
-		// if index 0 is an empty tile
-		for (int y = 0; y < state->levelHeight; y++) {
-			for (int x = 0; x < state->levelWidth; x++) {
-				if (state->levelData[y][x]) {
-					// add vertices
-					float spriteWidth = 21.0f / 694.0f;
-					float spriteHeight = 21.0f / 372.0f;
-					float u = (3 + (23 * ((int)state->levelData[y][x] % SPRITE_COUNT_X))) / 694.0f;
-					float v = (3 + (23 * ((int)state->levelData[y][x] / SPRITE_COUNT_X))) / 372.0f;
-
-					vertexData.insert(vertexData.end(), {
-						TILE_SIZE * x, -TILE_SIZE * y,
-						TILE_SIZE * x, (-TILE_SIZE * y) - TILE_SIZE,
-						(TILE_SIZE * x) + TILE_SIZE, (-TILE_SIZE * y) - TILE_SIZE,
-						TILE_SIZE * x, -TILE_SIZE * y,
-						(TILE_SIZE * x) + TILE_SIZE, (-TILE_SIZE * y) - TILE_SIZE,
-						(TILE_SIZE * x) + TILE_SIZE, -TILE_SIZE * y
-					});
-					texCoordData.insert(texCoordData.end(), {
-						u, v,
-						u, v + (spriteHeight),
-						u + spriteWidth, v + (spriteHeight),
-						u, v,
-						u + spriteWidth, v + (spriteHeight),
-						u + spriteWidth, v
-					});
-				}
-			}
-		}
-
-
-		float* vertices = &vertexData[0];
-		float* tex = &texCoordData[0];
-
-		//program.SetModelviewMatrix(modelMatrix*viewMatrix);
-		//program.SetProjectionMatrix(projectionMatrix);
-		//glUseProgram(program.programID);
-		glBindTexture(GL_TEXTURE_2D, 1);
+		ShaderProgram::BindTexture(state->tileTexture);
 		glClearColor(94.0f / 256, 129.0f / 256, 162.0f / 256, 0.0f);
-		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
-		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, tex);
-		glEnableVertexAttribArray(program.texCoordAttribute);
-		glDrawArrays(GL_TRIANGLES, 0, vertexData.size() / 2);
-
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
+		state->tileMesh->Draw(program);
 		break;
 	}
 	case GameState::STATE_TYPE::STATE_WIN: {}
@@ -917,75 +395,26 @@ void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, S
 		
 		program.SetModelviewMatrix(modelMatrix*viewMatrix);
 		program.SetProjectionMatrix(projectionMatrix);
-		glUseProgram(program.programID);
-		std::vector<float> vertexData;
-		std::vector<float> texCoordData;
-		float TILE_SIZE = 0.5f;
-		int SPRITE_COUNT_X = 16;
-		int SPRITE_COUNT_Y = 16;
-		// if index 0 is an empty tile
-		for (int y = 0; y < state->levelHeight; y++) {
-			for (int x = 0; x < state->levelWidth; x++) {
-				if (state->levelData[y][x]) {
-					// add vertices
-					float spriteWidth = 23.0f / 512.0f;
-					float spriteHeight = 23.0f / 512.0f;
-					float u = (4 + (32 * ((int)state->levelData[y][x] % SPRITE_COUNT_X))) / 512.0f;
-					float v = (4 + (32 * ((int)state->levelData[y][x] / SPRITE_COUNT_X))) / 512.0f;
-
-					vertexData.insert(vertexData.end(), {
-						TILE_SIZE * x, -TILE_SIZE * y,
-						TILE_SIZE * x, (-TILE_SIZE * y) - TILE_SIZE,
-						(TILE_SIZE * x) + TILE_SIZE, (-TILE_SIZE * y) - TILE_SIZE,
-						TILE_SIZE * x, -TILE_SIZE * y,
-						(TILE_SIZE * x) + TILE_SIZE, (-TILE_SIZE * y) - TILE_SIZE,
-						(TILE_SIZE * x) + TILE_SIZE, -TILE_SIZE * y
-					});
-					texCoordData.insert(texCoordData.end(), {
-						u, v,
-						u, v + (spriteHeight),
-						u + spriteWidth, v + (spriteHeight),
-						u, v,
-						u + spriteWidth, v + (spriteHeight),
-						u + spriteWidth, v
-					});
-				}
-			}
-		}
-
-
-		float* vertices = &vertexData[0];
-		float* tex = &texCoordData[0];
-
-		//program.SetModelviewMatrix(modelMatrix*viewMatrix);
-		//program.SetProjectionMatrix(projectionMatrix);
-		//glUseProgram(program.programID);
-		glBindTexture(GL_TEXTURE_2D, LoadTexture("textsheet.png"));
+		ShaderProgram::BindTexture(state->tileTexture);
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
-		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, tex);
-		glEnableVertexAttribArray(program.texCoordAttribute);
-		glDrawArrays(GL_TRIANGLES, 0, vertexData.size() / 2);
-
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
+		state->tileMesh->Draw(program);
 
 		break;
 	}
 	
 
-	for (Entity*& ent : state->entities) {
-		if (ent->alive) {
+	batch.Begin(program);
+	for (size_t ent = 0; ent < state->entities.Size(); ++ent) {
+		if (state->entities.alive[ent]) {
 			//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-			ent->Draw(program);
+			DrawEntity(batch, state->entities, ent, alpha);
 		}
 	}
-
-	SDL_GL_SwapWindow(displayWindow);
+	batch.End();
 }
 
 void Cleanup() {
-	
+	PROFILE_WRITE("trace.json");
+	textureCache.Clear();
 	SDL_Quit();
 }
\ No newline at end of file
@@ -4,16 +4,55 @@
 class Matrix {
     public:
     
-        Matrix();
+        constexpr Matrix() : m{ { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } {}
+
+        // Fixed transforms, usable in constant expressions so they can be built at compile time
+        static constexpr Matrix Translation(float x, float y, float z) {
+            Matrix r;
+            r.SetPosition(x, y, z);
+            return r;
+        }
+        static constexpr Matrix Scaling(float x, float y, float z) {
+            Matrix r;
+            r.SetScale(x, y, z);
+            return r;
+        }
+        static constexpr Matrix OrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar) {
+            Matrix r;
+            r.SetOrthoProjection(left, right, bottom, top, zNear, zFar);
+            return r;
+        }
+        // a * b one entry at a time, for constant expressions. Same result as operator*, which is
+        // the one to use at run time.
+        static constexpr Matrix Multiply(const Matrix &a, const Matrix &b) {
+            Matrix r;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+                }
+            }
+            return r;
+        }
     
         union {
             float m[4][4];
             float ml[16];
         };
     
-        void Identity();
+        constexpr void Identity() {
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    m[i][j] = i == j ? 1.0f : 0.0f;
+                }
+            }
+        }
         Matrix operator * (const Matrix &m2) const;
         Matrix Inverse() const;
+        // Only for matrices whose last column is 0 0 0 1, anything built from translate, scale,
+        // rotate and ortho projections
+        Matrix InverseAffine() const;
+        // Only for rotations and translations, no scale
+        Matrix InverseOrthonormal() const;
     
         void Translate(float x, float y, float z);
         void Scale(float x, float y, float z);
@@ -22,13 +61,29 @@ class Matrix {
         void Pitch(float pitch);
         void Yaw(float yaw);
     
-        void SetPosition(float x, float y, float z);
-        void SetScale(float x, float y, float z);
+        constexpr void SetPosition(float x, float y, float z) {
+            m[3][0] = x;
+            m[3][1] = y;
+            m[3][2] = z;
+        }
+        constexpr void SetScale(float x, float y, float z) {
+            m[0][0] = x;
+            m[1][1] = y;
+            m[2][2] = z;
+        }
         void SetRotation(float rotation);
         void SetRoll(float roll);
         void SetPitch(float pitch);
         void SetYaw(float yaw);
 
-        void SetOrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar);
+        constexpr void SetOrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar) {
+            m[0][0] = 2.0f/(right-left);
+            m[1][1] = 2.0f/(top-bottom);
+            m[2][2] = -2.0f/(zFar-zNear);
+
+            m[3][0] = -((right+left)/(right-left));
+            m[3][1] = -((top+bottom)/(top-bottom));
+            m[3][2] = -((zFar+zNear)/(zFar-zNear));
+        }
         void SetPerspectiveProjection(float fov, float aspect, float zNear, float zFar);
 };
@@ -27,7 +27,7 @@ GLuint LoadTexture(const char *filePath) {
 	}
 	GLuint retTexture;
 	glGenTextures(1, &retTexture);
-	glBindTexture(GL_TEXTURE_2D, retTexture);
+	ShaderProgram::BindTexture(retTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -53,8 +53,7 @@ int main(int argc, char *argv[])
 	GLuint spriteTexture = LoadTexture(RESOURCE_FOLDER"Sprite.png");
 	GLuint planeTexture = LoadTexture(RESOURCE_FOLDER"Plane.png");
 	GLuint spriteSpriteTexture = LoadTexture(RESOURCE_FOLDER"MoreSprite.png");
-	Matrix projectionMatrix;
-	projectionMatrix.SetOrthoProjection(-3.55f, 3.55f, -2.0f, 2.0f, -1.0f, 1.0f);
+	static constexpr Matrix projectionMatrix = Matrix::OrthoProjection(-3.55f, 3.55f, -2.0f, 2.0f, -1.0f, 1.0f);
 	Matrix modelviewMatrix;
 
 
@@ -68,39 +67,32 @@ int main(int argc, char *argv[])
 			}
 		}
 		glClear(GL_COLOR_BUFFER_BIT);
-		glUseProgram(program.programID);
 		program.SetModelviewMatrix(modelviewMatrix);
 		program.SetProjectionMatrix(projectionMatrix);
-		glBindTexture(GL_TEXTURE_2D, spriteTexture);
+		ShaderProgram::BindTexture(spriteTexture);
 		float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 1.5, -0.5, -0.5, 0.5, 1.5, -0.5, 1.5 };
 		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
+		ShaderProgram::EnableAttribute(program.positionAttribute);
 		float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
 		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
+		ShaderProgram::EnableAttribute(program.texCoordAttribute);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
-		glBindTexture(GL_TEXTURE_2D, planeTexture);
+		ShaderProgram::BindTexture(planeTexture);
 		float pVertices[] = { -2.5, -1.0, -1.5, -1.0, -1.5, 0, -2.5, -1.0, -1.5, 0, -2.5, 0 };
 		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, pVertices);
-		glEnableVertexAttribArray(program.positionAttribute);
+		ShaderProgram::EnableAttribute(program.positionAttribute);
 		float pTexCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
 		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, pTexCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
+		ShaderProgram::EnableAttribute(program.texCoordAttribute);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
-		glBindTexture(GL_TEXTURE_2D, spriteSpriteTexture);
+		ShaderProgram::BindTexture(spriteSpriteTexture);
 		float spVertices[] = { 1.0, 0.5, 3.0, 0.5, 3.0, 1.5, 1.0, 0.5, 3.0, 1.5, 1.0, 1.5 };
 		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, spVertices);
-		glEnableVertexAttribArray(program.positionAttribute);
+		ShaderProgram::EnableAttribute(program.positionAttribute);
 		float spTexCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
 		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, spTexCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
+		ShaderProgram::EnableAttribute(program.texCoordAttribute);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
 		SDL_GL_SwapWindow(displayWindow);
 	}
 
@@ -0,0 +1,68 @@
+#include "SpriteBatch.h"
+
+// x, y, u, v
+#define SPRITE_VERTEX_FLOATS 4
+
+SpriteBatch::SpriteBatch() : drawCalls(0), sprites(0), program(nullptr), texture(0), vertexBuffer(0) {}
+
+SpriteBatch::~SpriteBatch() {
+	if (vertexBuffer != 0) {
+		glDeleteBuffers(1, &vertexBuffer);
+	}
+}
+
+void SpriteBatch::Begin(ShaderProgram& program) {
+	this->program = &program;
+	texture = 0;
+	vertices.clear();
+	drawCalls = 0;
+	sprites = 0;
+	if (vertexBuffer == 0) {
+		glGenBuffers(1, &vertexBuffer);
+	}
+}
+
+void SpriteBatch::Draw(GLuint texture, float x, float y, float width, float height, float u, float v, float uWidth, float vHeight) {
+	if (texture != this->texture) {
+		Flush();
+		this->texture = texture;
+	}
+	float left = x - width / 2;
+	float right = x + width / 2;
+	float bottom = y - height / 2;
+	float top = y + height / 2;
+	vertices.insert(vertices.end(), {
+		left, bottom, u, v + vHeight,
+		right, bottom, u + uWidth, v + vHeight,
+		right, top, u + uWidth, v,
+		left, bottom, u, v + vHeight,
+		right, top, u + uWidth, v,
+		left, top, u, v
+	});
+	++sprites;
+}
+
+void SpriteBatch::End() {
+	Flush();
+	program = nullptr;
+}
+
+void SpriteBatch::Flush() {
+	if (vertices.empty() || program == nullptr) return;
+	const GLsizei stride = SPRITE_VERTEX_FLOATS * sizeof(float);
+	ShaderProgram::BindTexture(texture);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	// orphan last flush's storage so the driver doesn't stall on it
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), &vertices[0]);
+	glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, stride, (void*)0);
+	ShaderProgram::EnableAttribute(program->positionAttribute);
+	glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, stride, (void*)(2 * sizeof(float)));
+	ShaderProgram::EnableAttribute(program->texCoordAttribute);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / SPRITE_VERTEX_FLOATS));
+
+	// the attributes stay enabled, every draw sets both pointers first
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	++drawCalls;
+	vertices.clear();
+}
@@ -18,9 +18,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 // 60 FPS (1.0f/60.0f) (update sixty times a second)
 #define FIXED_TIMESTEP 0.0166666f
+// Render at most sixty frames a second, 0 for uncapped
+#define RENDER_RATE 60.0f
 #include "stb_image.h"
 #include "Matrix.h"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "FrameScheduler.h"
 
 
 #ifdef _WINDOWS
@@ -45,29 +49,6 @@ public:
 		textureID(textureID), u(coords[0]), v(coords[1]), width(coords[2]), height(coords[3]), size(size) {};
 	SheetSprite(unsigned int textureID, float u, float v, float width, float height, float size) : 
 		textureID(textureID), u(u), v(v), width(width), height(height), size(size) {}
-	void Draw(ShaderProgram& program) {
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		GLfloat texCoords[] = {
-			u, v + height,
-			u + width, v + height,
-			u + width, v,
-			u, v + height,
-			u + width, v,
-			u, v
-		};
-		float aspect = width / height;
-		float vertices[] = {
-			-0.5f * size * aspect, -0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, 0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, -0.5f * size ,
-			0.5f * size * aspect, -0.5f * size };
-		// draw our arrays
-		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-	}
 	float size;
 	unsigned int textureID;
 	float u;
@@ -79,32 +60,32 @@ public:
 // 3D Vector
 class Vector {
 public:
-	Vector() : x(0.0f), y(0.0f), z(0.0f), b(1.0f) {}
-	Vector(const float x, const float y, const float z) : x(x), y(y), z(z), b(1.0f) {}
-	Vector(const float x, const float y, const float z, const float b) : x(x), y(y), z(z), b(b) {}
-	Vector& operator=(Vector const& rhs) {
+	constexpr Vector() : x(0.0f), y(0.0f), z(0.0f), b(1.0f) {}
+	constexpr Vector(const float x, const float y, const float z) : x(x), y(y), z(z), b(1.0f) {}
+	constexpr Vector(const float x, const float y, const float z, const float b) : x(x), y(y), z(z), b(b) {}
+	constexpr Vector& operator=(Vector const& rhs) {
 		x = rhs.x;
 		y = rhs.y;
 		z = rhs.z;
 		b = rhs.b;
 		return *this;
 	}
-	Vector operator+(Vector const& rhs) const {
+	constexpr Vector operator+(Vector const& rhs) const {
 		Vector out(x + rhs.x, y + rhs.y, z + rhs.z, b + rhs.b);
 		return out;
 	}
-	Vector& operator+=(Vector const& rhs) {
+	constexpr Vector& operator+=(Vector const& rhs) {
 		x += rhs.x;
 		y += rhs.y;
 		z += rhs.z;
 		b += rhs.b;
 		return *this;
 	}
-	Vector operator*(const float num) const {
+	constexpr Vector operator*(const float num) const {
 		Vector out(x*num, y*num, z*num, b*num);
 		return out;
 	}
-	Vector& operator*=(const float num) {
+	constexpr Vector& operator*=(const float num) {
 		x *= num;
 		y *= num;
 		z *= num;
@@ -132,16 +113,8 @@ public:
 		matrix.SetPosition(x, y, 0.0f);
 		alive = true;
 	};
-	void Draw(ShaderProgram& program) {
-		//glBindTexture(GL_TEXTURE_2D, textureId);
-		float vertices[] = { position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2),
-			position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2), position.x - (size.x / 2), position.y + (size.y / 2) };
-		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
-		sprite.Draw(program);
-
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
+	void Draw(SpriteBatch& batch) {
+		batch.Draw(sprite.textureID, position.x, position.y, size.x, size.y, sprite.u, sprite.v, sprite.width, sprite.height);
 	}
 	Matrix translate(const float x, const float y, const float z) {
 		matrix.Translate(x, y, z);
@@ -194,7 +167,10 @@ GLuint LoadTexture(const char *filePath);
 
 float randf(float a, float b);
 
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height);
+// Where a sprite sits on its sheet as u, v, width and height, usable in constant expressions
+constexpr std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height) {
+	return { { float(xPx) / sheetWidth, float(yPx) / sheetHeight, float(width) / sheetWidth, float(height) / sheetHeight } };
+}
 
 bool readHeader(std::ifstream &stream, GameState* state);
 
@@ -212,7 +188,7 @@ void ProcessEvents(SDL_Event& event, bool& done, GameState* currentState, std::v
 
 void Update(GameState* state, float elapsed);
 
-void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, GameState* state);
+void Render(const Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state);
 
 void Cleanup();
 
@@ -227,12 +203,10 @@ int main(int argc, char *argv[])
 	ShaderProgram program = Setup();
 
 	// Setup Projection Matrix
-	Matrix projectionMatrix;
-	projectionMatrix.SetOrthoProjection(-7.1f, 7.1f, -4.0f, 4.0f, -1.0f, 1.0f);
+	static constexpr Matrix projectionMatrix = Matrix::OrthoProjection(-7.1f, 7.1f, -4.0f, 4.0f, -1.0f, 1.0f);
 	Matrix modelMatrix;
 	Matrix viewMatrix;
-
-	float lastFrameTicks = 0.0f;
+	SpriteBatch batch;
 
 	//Instantiate Objects, Textures, and States
 	
@@ -241,25 +215,25 @@ int main(int argc, char *argv[])
 	GameState* currentState = states[0];
 	SDL_Event event;
 	bool done = false;
-	float accumulator = 0.0f;
+	FrameScheduler scheduler(1.0f / FIXED_TIMESTEP, RENDER_RATE);
+	float reportTimer = 0.0f;
 	while (!done) {
+		// sleeps instead of spinning until the next frame is due
+		float elapsed = scheduler.WaitForNextFrame();
 		ProcessEvents(event, done, currentState, states);
 
-		float ticks = static_cast<float>(SDL_GetTicks()) / 1000.0f;
-		float elapsed = ticks - lastFrameTicks;
-		lastFrameTicks = ticks;
-		// get elapsed time
-		elapsed += accumulator;
-		if (elapsed < FIXED_TIMESTEP) {
-			accumulator = elapsed;
-			continue;
+		// bounded so a long hitch can't turn into an ever growing catch-up
+		int steps = scheduler.Accumulate(elapsed);
+		for (int i = 0; i < steps; ++i) {
+			Update(currentState, scheduler.UpdateStep());
 		}
-		while (elapsed >= FIXED_TIMESTEP) {
-			Update(currentState, FIXED_TIMESTEP);
-			elapsed -= FIXED_TIMESTEP;
+		Render(projectionMatrix, modelMatrix, viewMatrix, program, batch, currentState);
+		// once a second, what the last frame cost the batch
+		reportTimer += elapsed;
+		if (reportTimer >= 1.0f) {
+			std::cout << "Draw calls: " << batch.drawCalls << ", sprites: " << batch.sprites << std::endl;
+			reportTimer = 0.0f;
 		}
-		accumulator = elapsed;
-		Render(projectionMatrix, modelMatrix, viewMatrix, program, currentState);
 	}
 
 
@@ -282,7 +256,7 @@ GLuint LoadTexture(const char *filePath) {
 	}
 	GLuint retTexture;
 	glGenTextures(1, &retTexture);
-	glBindTexture(GL_TEXTURE_2D, retTexture);
+	ShaderProgram::BindTexture(retTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 	// LINEAR
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -331,16 +305,6 @@ float randf(float a, float b) {
 	return a + r;
 }
 
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height)
-{
-	std::array<float, 4> out;
-	out[0] = float(xPx) / sheetWidth;
-	out[1] = float(yPx) / sheetHeight;
-	out[2] = float(width) / sheetWidth;
-	out[3] = float(height) / sheetHeight;
-	return out;
-}
-
 bool readHeader(std::ifstream &stream, GameState* state) {
 	std::string line;
 	state->levelWidth = -1;
@@ -599,7 +563,7 @@ void Update(GameState* state, float elapsed) {
 
 
 
-void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, GameState* state) {
+void Render(const Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state) {
 	glClear(GL_COLOR_BUFFER_BIT);
 	modelMatrix.Identity();
 	viewMatrix.Identity();
@@ -612,7 +576,6 @@ void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, S
 	//viewMatrix.Translate(0.0f, 0.1f, 0.0f);
 	program.SetModelviewMatrix(modelMatrix*viewMatrix);
 	program.SetProjectionMatrix(projectionMatrix);
-	glUseProgram(program.programID);
 	std::vector<float> vertexData;
 	std::vector<float> texCoordData;
 	float TILE_SIZE = 1.0f;
@@ -655,22 +618,22 @@ void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, S
 	//program.SetModelviewMatrix(modelMatrix*viewMatrix);
 	//program.SetProjectionMatrix(projectionMatrix);
 	//glUseProgram(program.programID);
-	glBindTexture(GL_TEXTURE_2D, 1);
+	ShaderProgram::BindTexture(1);
 	glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-	glEnableVertexAttribArray(program.positionAttribute);
+	ShaderProgram::EnableAttribute(program.positionAttribute);
 	glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, tex);
-	glEnableVertexAttribArray(program.texCoordAttribute);
+	ShaderProgram::EnableAttribute(program.texCoordAttribute);
 	glDrawArrays(GL_TRIANGLES, 0, vertexData.size()/2);
 
-	glDisableVertexAttribArray(program.positionAttribute);
-	glDisableVertexAttribArray(program.texCoordAttribute);
 
+	batch.Begin(program);
 	for (Entity*& ent : state->entities) {
 		if (ent->alive) {
 			//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-			ent->Draw(program);
+			ent->Draw(batch);
 		}
 	}
+	batch.End();
 
 	SDL_GL_SwapWindow(displayWindow);
 }
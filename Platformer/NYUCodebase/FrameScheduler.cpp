@@ -0,0 +1,69 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+FrameScheduler::FrameScheduler(float updateRate, float renderRate) :
+	spinSeconds(0.002f), maxStepsPerFrame(5), dilateTime(false), minTimeScale(0.25f), framePeriod(0), accumulator(0.0f), timeScale(1.0f) {
+	frequency = SDL_GetPerformanceFrequency();
+	lastFrame = SDL_GetPerformanceCounter();
+	SetUpdateRate(updateRate);
+	SetRenderRate(renderRate);
+}
+
+void FrameScheduler::SetUpdateRate(float hz) {
+	updateStep = 1.0f / hz;
+}
+
+void FrameScheduler::SetRenderRate(float hz) {
+	framePeriod = hz > 0.0f ? (Uint64)(frequency / hz) : 0;
+	nextFrame = lastFrame + framePeriod;
+}
+
+float FrameScheduler::WaitForNextFrame() {
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (framePeriod > 0) {
+		if (now < nextFrame) {
+			Uint64 spin = (Uint64)(spinSeconds * frequency);
+			if (nextFrame - now > spin) {
+				SDL_Delay((Uint32)((nextFrame - now - spin) * 1000 / frequency));
+			}
+			while ((now = SDL_GetPerformanceCounter()) < nextFrame) {}
+		}
+		nextFrame += framePeriod;
+		// more than a frame late, start over from now instead of rushing the missed deadlines
+		if (nextFrame < now) nextFrame = now + framePeriod;
+	}
+	float elapsed = (float)(now - lastFrame) / frequency;
+	lastFrame = now;
+	return elapsed;
+}
+
+int FrameScheduler::Accumulate(float elapsed) {
+	++stats.frames;
+	float scaled = elapsed * timeScale;
+	stats.dilatedSeconds += elapsed - scaled;
+	accumulator += scaled;
+	int steps = 0;
+	while (accumulator >= updateStep && steps < maxStepsPerFrame) {
+		accumulator -= updateStep;
+		++steps;
+	}
+	if (accumulator >= updateStep) {
+		// over budget, keep only the partial step so the next frame doesn't inherit the backlog
+		++stats.overloadedFrames;
+		float kept = fmodf(accumulator, updateStep);
+		stats.droppedSeconds += accumulator - kept;
+		accumulator = kept;
+		if (dilateTime && elapsed > 0.0f) {
+			float fits = (maxStepsPerFrame * updateStep) / elapsed;
+			timeScale = std::max(minTimeScale, std::min(timeScale, fits));
+		}
+	}
+	else if (timeScale < 1.0f) {
+		// back to real time over about a second
+		timeScale = std::min(1.0f, timeScale + elapsed);
+	}
+	stats.steps += steps;
+	if (steps > 1) stats.catchUpSteps += steps - 1;
+	return steps;
+}
@@ -14,12 +14,19 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <cstdint>
 #define STB_IMAGE_IMPLEMENTATION
 // 60 FPS (1.0f/60.0f) (update sixty times a second)
 #define FIXED_TIMESTEP 0.0166666f
+// Downward acceleration, in world units per second squared
+#define GRAVITY -5.0f
+// Render at most sixty frames a second, 0 for uncapped
+#define RENDER_RATE 60.0f
 #include "stb_image.h"
 #include "Matrix.h"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "FrameScheduler.h"
 
 
 #ifdef _WINDOWS
@@ -44,29 +51,6 @@ public:
 		textureID(textureID), u(coords[0]), v(coords[1]), width(coords[2]), height(coords[3]), size(size) {};
 	SheetSprite(unsigned int textureID, float u, float v, float width, float height, float size) : 
 		textureID(textureID), u(u), v(v), width(width), height(height), size(size) {}
-	void Draw(ShaderProgram& program) {
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		GLfloat texCoords[] = {
-			u, v + height,
-			u + width, v + height,
-			u + width, v,
-			u, v + height,
-			u + width, v,
-			u, v
-		};
-		float aspect = width / height;
-		float vertices[] = {
-			-0.5f * size * aspect, -0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, 0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, -0.5f * size ,
-			0.5f * size * aspect, -0.5f * size };
-		// draw our arrays
-		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-	}
 	float size;
 	unsigned int textureID;
 	float u;
@@ -78,32 +62,32 @@ public:
 // 3D Vector
 class Vector {
 public:
-	Vector() : x(0.0f), y(0.0f), z(0.0f), b(1.0f) {}
-	Vector(const float x, const float y, const float z) : x(x), y(y), z(z), b(1.0f) {}
-	Vector(const float x, const float y, const float z, const float b) : x(x), y(y), z(z), b(b) {}
-	Vector& operator=(Vector const& rhs) {
+	constexpr Vector() : x(0.0f), y(0.0f), z(0.0f), b(1.0f) {}
+	constexpr Vector(const float x, const float y, const float z) : x(x), y(y), z(z), b(1.0f) {}
+	constexpr Vector(const float x, const float y, const float z, const float b) : x(x), y(y), z(z), b(b) {}
+	constexpr Vector& operator=(Vector const& rhs) {
 		x = rhs.x;
 		y = rhs.y;
 		z = rhs.z;
 		b = rhs.b;
 		return *this;
 	}
-	Vector operator+(Vector const& rhs) const {
+	constexpr Vector operator+(Vector const& rhs) const {
 		Vector out(x + rhs.x, y + rhs.y, z + rhs.z, b + rhs.b);
 		return out;
 	}
-	Vector& operator+=(Vector const& rhs) {
+	constexpr Vector& operator+=(Vector const& rhs) {
 		x += rhs.x;
 		y += rhs.y;
 		z += rhs.z;
 		b += rhs.b;
 		return *this;
 	}
-	Vector operator*(const float num) const {
+	constexpr Vector operator*(const float num) const {
 		Vector out(x*num, y*num, z*num, b*num);
 		return out;
 	}
-	Vector& operator*=(const float num) {
+	constexpr Vector& operator*=(const float num) {
 		x *= num;
 		y *= num;
 		z *= num;
@@ -123,48 +107,82 @@ public:
 	float x, y, z, b;
 };
 
-// Basic Game Object
-class Entity {
+// Names an entity of a store. Still safe to hold after the entity is destroyed: its slot gets a
+// new generation when freed, so Valid() turns false instead of the handle finding a stranger.
+struct EntityHandle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+// Every entity of a level as parallel arrays, element i of each belonging to entity i, so the
+// update pass streams through positions and velocities alone. Entities keep their index for as
+// long as they live and a destroyed one's slot goes to the next Create, so the arrays never shift.
+class EntityStore {
 public:
 	enum ENTITY_TYPE { ENTITY_PLAYER, ENTITY_SNAIL };
-	Entity(ENTITY_TYPE type, SheetSprite sprite, float x, float y) : position(x, y, 0.0f), size(1.0f, 1.0f, 1.0f), sprite(sprite), rotation(0.0f), type(type){
-		matrix.SetPosition(x, y, 0.0f);
-		alive = true;
-	};
-	void Draw(ShaderProgram& program) {
-		//glBindTexture(GL_TEXTURE_2D, textureId);
-		float vertices[] = { position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2),
-			position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2), position.x - (size.x / 2), position.y + (size.y / 2) };
-		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
-		sprite.Draw(program);
-
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
+
+	EntityHandle Create(ENTITY_TYPE entityType, const SheetSprite& entitySprite, float placeX, float placeY) {
+		size_t index;
+		if (freeSlots.empty()) {
+			index = Size();
+			x.push_back(0.0f); y.push_back(0.0f);
+			velocityX.push_back(0.0f); velocityY.push_back(0.0f);
+			width.push_back(0.0f); height.push_back(0.0f);
+			type.push_back(0); alive.push_back(0);
+			sprite.push_back(entitySprite);
+			generation.push_back(0);
+			used.push_back(0);
+		}
+		else {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		x[index] = placeX;
+		y[index] = placeY;
+		velocityX[index] = velocityY[index] = 0.0f;
+		width[index] = height[index] = 1.0f;
+		type[index] = (uint8_t)entityType;
+		alive[index] = true;
+		sprite[index] = entitySprite;
+		used[index] = 1;
+		return Handle(index);
+	}
+	void Destroy(EntityHandle handle) {
+		if (!Valid(handle)) return;
+		alive[handle.index] = false;
+		used[handle.index] = 0;
+		// any handle still out there no longer matches
+		++generation[handle.index];
+		freeSlots.push_back(handle.index);
 	}
-	Matrix translate(const float x, const float y, const float z) {
-		matrix.Translate(x, y, z);
-		position += Vector(x, y, z);
-		return matrix;
+	bool Valid(EntityHandle handle) const {
+		return handle.index < Size() && used[handle.index] && generation[handle.index] == handle.generation;
 	}
+	EntityHandle Handle(size_t index) const { return { (uint32_t)index, generation[index] }; }
+	// Slots, including freed ones
+	size_t Size() const { return x.size(); }
 
-	Matrix matrix;
-	Vector position;
-	Vector size;
-	Vector velocity;
-	Vector acceleration;
-	SheetSprite sprite;
-	float rotation;
-	ENTITY_TYPE type;
-	bool alive;
-	/*
-	 *  contact indices clockwise:
-	 *		0
-	 *	3  obj	1
-	 *		2
-	 */
-	bool* contact[4];
+	void Draw(SpriteBatch& batch, size_t index) const {
+		const SheetSprite& look = sprite[index];
+		batch.Draw(look.textureID, x[index], y[index], width[index], height[index], look.u, look.v, look.width, look.height);
+	}
 
+	// read or written by every step
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> width;
+	std::vector<float> height;
+	std::vector<uint8_t> type;
+	std::vector<uint8_t> alive;
+	// only drawing reads these
+	std::vector<SheetSprite> sprite;
+
+private:
+	std::vector<uint32_t> generation;
+	std::vector<uint8_t> used;
+	std::vector<uint32_t> freeSlots;
 };
 
 // Game States
@@ -172,7 +190,7 @@ class GameState {
 public:
 	enum STATE_TYPE { STATE_MENU, STATE_GAME };
 	GameState(STATE_TYPE type) : type(type) {}
-	std::vector<Entity*> entities;
+	EntityStore entities;
 	int** levelData;
 	int levelWidth;
 	int levelHeight;
@@ -192,7 +210,10 @@ GLuint LoadTexture(const char *filePath);
 
 float randf(float a, float b);
 
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height);
+// Where a sprite sits on its sheet as u, v, width and height, usable in constant expressions
+constexpr std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height) {
+	return { { float(xPx) / sheetWidth, float(yPx) / sheetHeight, float(width) / sheetWidth, float(height) / sheetHeight } };
+}
 
 bool readHeader(std::ifstream &stream, GameState* state);
 
@@ -210,7 +231,7 @@ void ProcessEvents(SDL_Event& event, bool& done, GameState* currentState, std::v
 
 void Update(GameState* state, float elapsed);
 
-void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, GameState* state);
+void Render(const Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state);
 
 void Cleanup();
 
@@ -225,12 +246,10 @@ int main(int argc, char *argv[])
 	ShaderProgram program = Setup();
 
 	// Setup Projection Matrix
-	Matrix projectionMatrix;
-	projectionMatrix.SetOrthoProjection(-7.1f, 7.1f, -4.0f, 4.0f, -1.0f, 1.0f);
+	static constexpr Matrix projectionMatrix = Matrix::OrthoProjection(-7.1f, 7.1f, -4.0f, 4.0f, -1.0f, 1.0f);
 	Matrix modelMatrix;
 	Matrix viewMatrix;
-
-	float lastFrameTicks = 0.0f;
+	SpriteBatch batch;
 
 	//Instantiate Objects, Textures, and States
 	
@@ -239,25 +258,25 @@ int main(int argc, char *argv[])
 	GameState* currentState = states[0];
 	SDL_Event event;
 	bool done = false;
-	float accumulator = 0.0f;
+	FrameScheduler scheduler(1.0f / FIXED_TIMESTEP, RENDER_RATE);
+	float reportTimer = 0.0f;
 	while (!done) {
+		// sleeps instead of spinning until the next frame is due
+		float elapsed = scheduler.WaitForNextFrame();
 		ProcessEvents(event, done, currentState, states);
 
-		float ticks = static_cast<float>(SDL_GetTicks()) / 1000.0f;
-		float elapsed = ticks - lastFrameTicks;
-		lastFrameTicks = ticks;
-		// get elapsed time
-		elapsed += accumulator;
-		if (elapsed < FIXED_TIMESTEP) {
-			accumulator = elapsed;
-			continue;
+		// bounded so a long hitch can't turn into an ever growing catch-up
+		int steps = scheduler.Accumulate(elapsed);
+		for (int i = 0; i < steps; ++i) {
+			Update(currentState, scheduler.UpdateStep());
 		}
-		while (elapsed >= FIXED_TIMESTEP) {
-			Update(currentState, FIXED_TIMESTEP);
-			elapsed -= FIXED_TIMESTEP;
+		Render(projectionMatrix, modelMatrix, viewMatrix, program, batch, currentState);
+		// once a second, what the last frame cost the batch
+		reportTimer += elapsed;
+		if (reportTimer >= 1.0f) {
+			std::cout << "Draw calls: " << batch.drawCalls << ", sprites: " << batch.sprites << std::endl;
+			reportTimer = 0.0f;
 		}
-		accumulator = elapsed;
-		Render(projectionMatrix, modelMatrix, viewMatrix, program, currentState);
 	}
 
 
@@ -280,7 +299,7 @@ GLuint LoadTexture(const char *filePath) {
 	}
 	GLuint retTexture;
 	glGenTextures(1, &retTexture);
-	glBindTexture(GL_TEXTURE_2D, retTexture);
+	ShaderProgram::BindTexture(retTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 	// LINEAR
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -292,30 +311,24 @@ GLuint LoadTexture(const char *filePath) {
 	return retTexture;
 }
 
-bool isCollidingRect(Entity* r1, Entity* r2){
+bool isCollidingRect(const EntityStore& entities, size_t r1, Vector position, Vector size) {
+	float x = entities.x[r1];
+	float y = entities.y[r1];
+	float height = entities.height[r1];
 	// Is r1 bottom > r2 top?
-	if (r1->position.y - r1->size.y / 2 > r2->position.y + r2->size.y / 2) return false;
+	if (y - height / 2 > position.y + size.y / 2) return false;
 	// Is r1 top < r2 bottom?
-	if (r1->position.y + r1->size.y / 2 < r2->position.y - r2->size.y / 2) return false;
+	if (y + height / 2 < position.y - size.y / 2) return false;
 	// Is r1 left > r2 right?
-	if (r1->position.x - r1->size.y / 2 > r2->position.x + r2->size.y / 2) return false;
+	if (x - height / 2 > position.x + size.y / 2) return false;
 	// Is r1 right < r2 left?
-	if (r1->position.x + r1->size.y / 2 < r2->position.x - r2->size.y / 2) return false;
+	if (x + height / 2 < position.x - size.y / 2) return false;
 
 	return true;
 }
 
-bool isCollidingRect(Entity* r1, Vector position, Vector size) {
-	// Is r1 bottom > r2 top?
-	if (r1->position.y - r1->size.y / 2 > position.y + size.y / 2) return false;
-	// Is r1 top < r2 bottom?
-	if (r1->position.y + r1->size.y / 2 < position.y - size.y / 2) return false;
-	// Is r1 left > r2 right?
-	if (r1->position.x - r1->size.y / 2 > position.x + size.y / 2) return false;
-	// Is r1 right < r2 left?
-	if (r1->position.x + r1->size.y / 2 < position.x - size.y / 2) return false;
-
-	return true;
+bool isCollidingRect(const EntityStore& entities, size_t r1, size_t r2){
+	return isCollidingRect(entities, r1, Vector(entities.x[r2], entities.y[r2], 0.0f), Vector(entities.width[r2], entities.height[r2], 0.0f));
 }
 
 float lerp(float v0, float v1, float t) {
@@ -329,16 +342,6 @@ float randf(float a, float b) {
 	return a + r;
 }
 
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height)
-{
-	std::array<float, 4> out;
-	out[0] = float(xPx) / sheetWidth;
-	out[1] = float(yPx) / sheetHeight;
-	out[2] = float(width) / sheetWidth;
-	out[3] = float(height) / sheetHeight;
-	return out;
-}
-
 bool readHeader(std::ifstream &stream, GameState* state) {
 	std::string line;
 	state->levelWidth = -1;
@@ -424,10 +427,10 @@ bool readEntityData(std::ifstream &stream, GameState* state, int TILE_SIZE) {
 }
 
 void placeEntity(std::string type, GameState* state, float placeX, float placeY) {
-	Entity::ENTITY_TYPE entityType;
-	if (type == "Player") entityType = Entity::ENTITY_PLAYER;
-	else if (type == "Snail") entityType = Entity::ENTITY_SNAIL;
-	state->entities.push_back(new Entity(entityType, state->sprites[entityType], placeX, placeY));
+	EntityStore::ENTITY_TYPE entityType;
+	if (type == "Player") entityType = EntityStore::ENTITY_PLAYER;
+	else if (type == "Snail") entityType = EntityStore::ENTITY_SNAIL;
+	state->entities.Create(entityType, state->sprites[entityType], placeX, placeY);
 }
 
 
@@ -467,8 +470,8 @@ ShaderProgram Setup() {
 std::vector<GameState*> Instantiate() {
 	std::vector<GameState*> states;
 	states.push_back(new GameState(GameState::STATE_GAME));
-	states[0]->sprites[Entity::ENTITY_PLAYER] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 19 + 19 * 2, 3 + 21 * 0, 21, 21), 1.0f);
-	states[0]->sprites[Entity::ENTITY_SNAIL] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 14 + 2 * 14, 3 + 21 * 15 + 2*15, 21, 21), 1.0f);
+	states[0]->sprites[EntityStore::ENTITY_PLAYER] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 19 + 19 * 2, 3 + 21 * 0, 21, 21), 1.0f);
+	states[0]->sprites[EntityStore::ENTITY_SNAIL] = SheetSprite(LoadTexture("spritesheet.png"), pxToUV(694, 372, 3 + 21 * 14 + 2 * 14, 3 + 21 * 15 + 2*15, 21, 21), 1.0f);
 	states[0]->solids[124 - 1] = true;
 	states[0]->solids[127 - 1] = true;
 	states[0]->solids[126 - 1] = true;
@@ -516,9 +519,9 @@ void ProcessEvents(SDL_Event & event, bool& done, GameState* currentState, std::
 			if (currentState->type == GameState::STATE_MENU) {
 				currentState = states[1];
 			}
-			else if (currentState->type == GameState::STATE_GAME && currentState->entities[0]->alive) {
+			else if (currentState->type == GameState::STATE_GAME && currentState->entities.alive[0]) {
 				if (event.key.keysym.scancode == SDL_SCANCODE_SPACE) {
-					currentState->entities[0]->velocity.y = 5;
+					currentState->entities.velocityY[0] = 5;
 				}
 			}
 			
@@ -527,11 +530,12 @@ void ProcessEvents(SDL_Event & event, bool& done, GameState* currentState, std::
 
 	// Keyboard Polling
 	const Uint8* keys = SDL_GetKeyboardState(NULL);
-	if (keys[SDL_SCANCODE_RIGHT] && currentState->entities[0]->position.x + currentState->entities[0]->size.x / 2 < 40) {
-		currentState->entities[0]->velocity.x = 2;
+	EntityStore& entities = currentState->entities;
+	if (keys[SDL_SCANCODE_RIGHT] && entities.x[0] + entities.width[0] / 2 < 40) {
+		entities.velocityX[0] = 2;
 	}
-	if (keys[SDL_SCANCODE_LEFT] && currentState->entities[0]->position.x - currentState->entities[0]->size.x / 2 > 0.0f) {
-		currentState->entities[0]->velocity.x = -2;
+	if (keys[SDL_SCANCODE_LEFT] && entities.x[0] - entities.width[0] / 2 > 0.0f) {
+		entities.velocityX[0] = -2;
 	}
 	
 
@@ -539,38 +543,39 @@ void ProcessEvents(SDL_Event & event, bool& done, GameState* currentState, std::
 }
 
 void Update(GameState* state, float elapsed) {
-	state->entities[1]->velocity.x = -1;
-	for (Entity*& ent : state->entities) {
-		ent->acceleration.y = -5.0f;
-		if (ent->alive) {
+	EntityStore& entities = state->entities;
+	entities.velocityX[1] = -1;
+	for (size_t ent = 0; ent < entities.Size(); ++ent) {
+		if (entities.alive[ent]) {
 			
-			ent->velocity.x = lerp(ent->velocity.x, 0.0f, elapsed);
-			ent->velocity.x += ent->acceleration.x*elapsed;
-			ent->position += ent->velocity * elapsed;
+			entities.velocityX[ent] = lerp(entities.velocityX[ent], 0.0f, elapsed);
+			entities.x[ent] += entities.velocityX[ent] * elapsed;
+			entities.y[ent] += entities.velocityY[ent] * elapsed;
 
-			ent->velocity.y += ent->acceleration.y * elapsed;
+			entities.velocityY[ent] += GRAVITY * elapsed;
 			for (int y = 0; y < state->levelHeight; ++y) {
 				for (int x = 0; x < state->levelWidth; ++x) {
 					if (state->solids[state->levelData[y][x]]) {
 						Vector pos(x + 0.5f, -y - 0.5f, 0.0f);
 						Vector size(1.0f, 1.0f, 0.0f);
-						if (isCollidingRect(ent, pos, size)) {
-							ent->position.y += ((pos.y + size.y / 2) - (ent->position.y - ent->size.y / 2))*elapsed;
-							//ent->position.x += ((pos.x + size.x / 2) - (ent->position.x - ent->size.x / 2))*elapsed;
-							ent->velocity.y = 0;
-							if (state->levelData[y][x] == 70) ent->alive = false;
+						if (isCollidingRect(entities, ent, pos, size)) {
+							entities.y[ent] += ((pos.y + size.y / 2) - (entities.y[ent] - entities.height[ent] / 2))*elapsed;
+							//entities.x[ent] += ((pos.x + size.x / 2) - (entities.x[ent] - entities.width[ent] / 2))*elapsed;
+							entities.velocityY[ent] = 0;
+							if (state->levelData[y][x] == 70) entities.alive[ent] = false;
 						}
 					}
 				}
 			}
-			Entity* player = state->entities[0];
-			if(ent != state->entities[0] && isCollidingRect(player, ent)) {
-				if(player->position.y - (player->size.y/2) >= ent->position.y + (ent->size.y/2) - 0.1f && player->velocity.y < 0) {
-					ent->alive = false;
-					player->velocity.y = 5;
+			// the player is always entity 0
+			const size_t player = 0;
+			if(ent != player && isCollidingRect(entities, player, ent)) {
+				if(entities.y[player] - (entities.height[player]/2) >= entities.y[ent] + (entities.height[ent]/2) - 0.1f && entities.velocityY[player] < 0) {
+					entities.alive[ent] = false;
+					entities.velocityY[player] = 5;
 				}
 				else {
-					player->alive = false;
+					entities.alive[player] = false;
 				}
 				//else if(ent1 == state->e)
 			}
@@ -581,20 +586,20 @@ void Update(GameState* state, float elapsed) {
 
 
 
-void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, GameState* state) {
+void Render(const Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state) {
 	glClear(GL_COLOR_BUFFER_BIT);
 	modelMatrix.Identity();
 	viewMatrix.Identity();
-	if(state->entities[0]->position.x < 7.1) viewMatrix.Translate(-7.1f, 0.0f, 0.0f);
-	else if (state->entities[0]->position.x > 40-7.1) viewMatrix.Translate(-(40-7.1), 0.0f, 0.0f);
-	else viewMatrix.Translate(-state->entities[0]->position.x, 0.0f, 0.0f);
-	if (state->entities[0]->position.y < -9.0) viewMatrix.Translate(0.0f, 9.0f, 0.0f);
-	else viewMatrix.Translate(0.0f, -state->entities[0]->position.y, 0.0f);
+	const EntityStore& entities = state->entities;
+	if(entities.x[0] < 7.1) viewMatrix.Translate(-7.1f, 0.0f, 0.0f);
+	else if (entities.x[0] > 40-7.1) viewMatrix.Translate(-(40-7.1), 0.0f, 0.0f);
+	else viewMatrix.Translate(-entities.x[0], 0.0f, 0.0f);
+	if (entities.y[0] < -9.0) viewMatrix.Translate(0.0f, 9.0f, 0.0f);
+	else viewMatrix.Translate(0.0f, -entities.y[0], 0.0f);
 
 	//viewMatrix.Translate(0.0f, 0.1f, 0.0f);
 	program.SetModelviewMatrix(modelMatrix*viewMatrix);
 	program.SetProjectionMatrix(projectionMatrix);
-	glUseProgram(program.programID);
 	std::vector<float> vertexData;
 	std::vector<float> texCoordData;
 	float TILE_SIZE = 1.0f;
@@ -637,22 +642,22 @@ void Render(Matrix& projectionMatrix, Matrix& modelMatrix, Matrix& viewMatrix, S
 	//program.SetModelviewMatrix(modelMatrix*viewMatrix);
 	//program.SetProjectionMatrix(projectionMatrix);
 	//glUseProgram(program.programID);
-	glBindTexture(GL_TEXTURE_2D, 1);
+	ShaderProgram::BindTexture(1);
 	glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-	glEnableVertexAttribArray(program.positionAttribute);
+	ShaderProgram::EnableAttribute(program.positionAttribute);
 	glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, tex);
-	glEnableVertexAttribArray(program.texCoordAttribute);
+	ShaderProgram::EnableAttribute(program.texCoordAttribute);
 	glDrawArrays(GL_TRIANGLES, 0, vertexData.size()/2);
 
-	glDisableVertexAttribArray(program.positionAttribute);
-	glDisableVertexAttribArray(program.texCoordAttribute);
 
-	for (Entity*& ent : state->entities) {
-		if (ent->alive) {
+	batch.Begin(program);
+	for (size_t ent = 0; ent < entities.Size(); ++ent) {
+		if (entities.alive[ent]) {
 			//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-			ent->Draw(program);
+			entities.Draw(batch, ent);
 		}
 	}
+	batch.End();
 
 	SDL_GL_SwapWindow(displayWindow);
 }
@@ -2,30 +2,48 @@
 #include "Matrix.h"
 #include <math.h>
 
-Matrix::Matrix() {
-    Identity();
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define MATRIX_SSE
+#endif
+
+// every entry equal, for the checks below
+static constexpr bool sameEntries(const Matrix &a, const Matrix &b) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (a.m[i][j] != b.m[i][j]) return false;
+        }
+    }
+    return true;
 }
 
-void Matrix::Identity() {
-    m[0][0] = 1.0;
-    m[1][0] = 0.0;
-    m[2][0] = 0.0;
-    m[3][0] = 0.0;
-    
-    m[0][1] = 0.0;
-    m[1][1] = 1.0;
-    m[2][1] = 0.0;
-    m[3][1] = 0.0;
+// Checked by the compiler, every project that builds this file runs them
+static_assert(sameEntries(Matrix::Multiply(Matrix(), Matrix::Translation(1.0f, 2.0f, 3.0f)), Matrix::Translation(1.0f, 2.0f, 3.0f)), "identity * m is m");
+static_assert(sameEntries(Matrix::Multiply(Matrix::Translation(1.0f, 2.0f, 3.0f), Matrix::Translation(4.0f, 5.0f, 6.0f)), Matrix::Translation(5.0f, 7.0f, 9.0f)), "translations add up");
+static_assert(sameEntries(Matrix::Multiply(Matrix::Scaling(2.0f, 4.0f, 1.0f), Matrix::Scaling(0.5f, 0.25f, 1.0f)), Matrix()), "scales multiply");
+static_assert(Matrix::Multiply(Matrix::Translation(1.0f, 0.0f, 0.0f), Matrix::Scaling(2.0f, 3.0f, 1.0f)).m[3][0] == 2.0f, "a row vector is translated before it is scaled");
+static_assert(sameEntries(Matrix::OrthoProjection(-2.0f, 2.0f, -4.0f, 4.0f, -1.0f, 1.0f), Matrix::Scaling(0.5f, 0.25f, -1.0f)), "a centred ortho projection only scales");
+static_assert(Matrix::OrthoProjection(0.0f, 4.0f, 0.0f, 2.0f, -1.0f, 1.0f).m[3][0] == -1.0f, "the left edge maps to -1");
 
-    m[0][2] = 0.0;
-    m[1][2] = 0.0;
-    m[2][2] = 1.0;
-    m[3][2] = 0.0;
+// sin and cos of the same angle in one call where the C library has one
+static inline void sinCos(float angle, float &s, float &c) {
+#if defined(__GLIBC__)
+    sincosf(angle, &s, &c);
+#else
+    s = sinf(angle);
+    c = cosf(angle);
+#endif
+}
 
-    m[0][3] = 0.0;
-    m[1][3] = 0.0;
-    m[2][3] = 0.0;
-    m[3][3] = 1.0;
+// row = a * row + b * other on all four columns
+static inline void combineRows(float *row, float a, const float *other, float b) {
+#if defined(MATRIX_SSE)
+    _mm_storeu_ps(row, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a), _mm_loadu_ps(row)), _mm_mul_ps(_mm_set1_ps(b), _mm_loadu_ps(other))));
+#else
+    for (int i = 0; i < 4; i++) {
+        row[i] = a * row[i] + b * other[i];
+    }
+#endif
 }
 
 Matrix Matrix::Inverse() const {
@@ -102,42 +120,76 @@ Matrix Matrix::Inverse() const {
     return m2;
 }
 
-Matrix Matrix::operator * (const Matrix &m2) const {
-    Matrix r;
-    
-    r.m[0][0] = m[0][0] * m2.m[0][0] + m[0][1] * m2.m[1][0] + m[0][2] * m2.m[2][0] + m[0][3] * m2.m[3][0];
-    r.m[0][1] = m[0][0] * m2.m[0][1] + m[0][1] * m2.m[1][1] + m[0][2] * m2.m[2][1] + m[0][3] * m2.m[3][1];
-    r.m[0][2] = m[0][0] * m2.m[0][2] + m[0][1] * m2.m[1][2] + m[0][2] * m2.m[2][2] + m[0][3] * m2.m[3][2];
-    r.m[0][3] = m[0][0] * m2.m[0][3] + m[0][1] * m2.m[1][3] + m[0][2] * m2.m[2][3] + m[0][3] * m2.m[3][3];
+Matrix Matrix::InverseAffine() const {
+    // the 3x3 part by cofactors, the translation row goes back through it
+    float a00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float a01 = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    float a02 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    float a10 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float a11 = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    float a12 = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    float a20 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float a21 = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    float a22 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
     
-    r.m[1][0] = m[1][0] * m2.m[0][0] + m[1][1] * m2.m[1][0] + m[1][2] * m2.m[2][0] + m[1][3] * m2.m[3][0];
-    r.m[1][1] = m[1][0] * m2.m[0][1] + m[1][1] * m2.m[1][1] + m[1][2] * m2.m[2][1] + m[1][3] * m2.m[3][1];
-    r.m[1][2] = m[1][0] * m2.m[0][2] + m[1][1] * m2.m[1][2] + m[1][2] * m2.m[2][2] + m[1][3] * m2.m[3][2];
-    r.m[1][3] = m[1][0] * m2.m[0][3] + m[1][1] * m2.m[1][3] + m[1][2] * m2.m[2][3] + m[1][3] * m2.m[3][3];
+    float invDet = 1.0f / (m[0][0] * a00 + m[0][1] * a10 + m[0][2] * a20);
     
-    r.m[2][0] = m[2][0] * m2.m[0][0] + m[2][1] * m2.m[1][0] + m[2][2] * m2.m[2][0] + m[2][3] * m2.m[3][0];
-    r.m[2][1] = m[2][0] * m2.m[0][1] + m[2][1] * m2.m[1][1] + m[2][2] * m2.m[2][1] + m[2][3] * m2.m[3][1];
-    r.m[2][2] = m[2][0] * m2.m[0][2] + m[2][1] * m2.m[1][2] + m[2][2] * m2.m[2][2] + m[2][3] * m2.m[3][2];
-    r.m[2][3] = m[2][0] * m2.m[0][3] + m[2][1] * m2.m[1][3] + m[2][2] * m2.m[2][3] + m[2][3] * m2.m[3][3];
-    
-    r.m[3][0] = m[3][0] * m2.m[0][0] + m[3][1] * m2.m[1][0] + m[3][2] * m2.m[2][0] + m[3][3] * m2.m[3][0];
-    r.m[3][1] = m[3][0] * m2.m[0][1] + m[3][1] * m2.m[1][1] + m[3][2] * m2.m[2][1] + m[3][3] * m2.m[3][1];
-    r.m[3][2] = m[3][0] * m2.m[0][2] + m[3][1] * m2.m[1][2] + m[3][2] * m2.m[2][2] + m[3][3] * m2.m[3][2];
-    r.m[3][3] = m[3][0] * m2.m[0][3] + m[3][1] * m2.m[1][3] + m[3][2] * m2.m[2][3] + m[3][3] * m2.m[3][3];
-    
-    return r;
+    Matrix m2;
+    m2.m[0][0] = a00 * invDet;
+    m2.m[0][1] = a01 * invDet;
+    m2.m[0][2] = a02 * invDet;
+    m2.m[1][0] = a10 * invDet;
+    m2.m[1][1] = a11 * invDet;
+    m2.m[1][2] = a12 * invDet;
+    m2.m[2][0] = a20 * invDet;
+    m2.m[2][1] = a21 * invDet;
+    m2.m[2][2] = a22 * invDet;
+    for (int j = 0; j < 3; j++) {
+        m2.m[3][j] = -(m[3][0] * m2.m[0][j] + m[3][1] * m2.m[1][j] + m[3][2] * m2.m[2][j]);
+    }
+    return m2;
 }
 
-void Matrix::SetPosition(float x, float y, float z) {
-    m[3][0] = x;
-    m[3][1] = y;
-    m[3][2] = z;
+Matrix Matrix::InverseOrthonormal() const {
+    // the inverse of a rotation is its transpose
+    Matrix m2;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            m2.m[i][j] = m[j][i];
+        }
+    }
+    for (int j = 0; j < 3; j++) {
+        m2.m[3][j] = -(m[3][0] * m[j][0] + m[3][1] * m[j][1] + m[3][2] * m[j][2]);
+    }
+    return m2;
+}
+
+Matrix Matrix::operator * (const Matrix &m2) const {
+    Matrix r;
+#if defined(MATRIX_SSE)
+    // each row of r is this row's entries times the rows of m2, summed in the same order as below
+    __m128 row0 = _mm_loadu_ps(m2.m[0]);
+    __m128 row1 = _mm_loadu_ps(m2.m[1]);
+    __m128 row2 = _mm_loadu_ps(m2.m[2]);
+    __m128 row3 = _mm_loadu_ps(m2.m[3]);
+    for (int i = 0; i < 4; i++) {
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(m[i][0]), row0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m[i][1]), row1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m[i][2]), row2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(m[i][3]), row3));
+        _mm_storeu_ps(r.m[i], sum);
+    }
+#else
+    r = Multiply(*this, m2);
+#endif
+    return r;
 }
 
 void Matrix::Translate(float x, float y, float z) {
-    Matrix transMatrix;
-    transMatrix.SetPosition(x, y, z);
-    (*this) = transMatrix * (*this);
+    // translation * this only changes the last row
+    for (int j = 0; j < 4; j++) {
+        m[3][j] = x * m[0][j] + y * m[1][j] + z * m[2][j] + m[3][j];
+    }
 }
 
 void Matrix::SetRotation(float rotation) {
@@ -145,10 +197,12 @@ void Matrix::SetRotation(float rotation) {
 }
 
 void Matrix::SetRoll(float roll) {
-    m[0][0] = cos(roll);
-    m[1][0] = -sin(roll);
-    m[0][1] = sin(roll);
-    m[1][1] = cos(roll);
+    float s, c;
+    sinCos(roll, s, c);
+    m[0][0] = c;
+    m[1][0] = -s;
+    m[0][1] = s;
+    m[1][1] = c;
 }
 
 void Matrix::Rotate(float rotation) {
@@ -156,57 +210,58 @@ void Matrix::Rotate(float rotation) {
 }
 
 void Matrix::Roll(float roll) {
-    Matrix rollMatrix;
-    rollMatrix.SetRoll(roll);
-    (*this) = rollMatrix * (*this);
+    // roll * this only mixes the first two rows
+    float s, c;
+    sinCos(roll, s, c);
+    float row0[4] = { m[0][0], m[0][1], m[0][2], m[0][3] };
+    combineRows(m[0], c, m[1], s);
+    combineRows(m[1], c, row0, -s);
 }
 
 void Matrix::SetPitch(float pitch) {
-    m[1][1] = cos(pitch);
-    m[2][1] = -sin(pitch);
-    m[1][2] = sin(pitch);
-    m[2][2] = cos(pitch);
+    float s, c;
+    sinCos(pitch, s, c);
+    m[1][1] = c;
+    m[2][1] = -s;
+    m[1][2] = s;
+    m[2][2] = c;
 }
 
 void Matrix::SetYaw(float yaw) {
-    m[0][0] = cos(yaw);
-    m[2][0] = sin(yaw);
-    m[0][2] = -sin(yaw);
-    m[2][2] = cos(yaw);
+    float s, c;
+    sinCos(yaw, s, c);
+    m[0][0] = c;
+    m[2][0] = s;
+    m[0][2] = -s;
+    m[2][2] = c;
 }
 
 void Matrix::Pitch(float pitch) {
-    Matrix pitchMatrix;
-    pitchMatrix.SetPitch(pitch);
-    (*this) = pitchMatrix * (*this);
+    // pitch * this only mixes the middle two rows
+    float s, c;
+    sinCos(pitch, s, c);
+    float row1[4] = { m[1][0], m[1][1], m[1][2], m[1][3] };
+    combineRows(m[1], c, m[2], s);
+    combineRows(m[2], c, row1, -s);
 }
 
 void Matrix::Yaw(float yaw) {
-    Matrix yawMatrix;
-    yawMatrix.SetYaw(yaw);
-    (*this) = yawMatrix * (*this);
-}
-
-void Matrix::SetScale(float x, float y, float z) {
-    m[0][0] = x;
-    m[1][1] = y;
-    m[2][2] = z;
+    // yaw * this only mixes the first and third rows
+    float s, c;
+    sinCos(yaw, s, c);
+    float row0[4] = { m[0][0], m[0][1], m[0][2], m[0][3] };
+    combineRows(m[0], c, m[2], -s);
+    combineRows(m[2], c, row0, s);
 }
 
 void Matrix::Scale(float x, float y, float z) {
-    Matrix scaleMatrix;
-    scaleMatrix.SetScale(x, y, z);
-    (*this) = scaleMatrix * (*this);
-}
-
-void Matrix::SetOrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar) {
-    m[0][0] = 2.0f/(right-left);
-    m[1][1] = 2.0f/(top-bottom);
-    m[2][2] = -2.0f/(zFar-zNear);
-
-    m[3][0] = -((right+left)/(right-left));
-    m[3][1] = -((top+bottom)/(top-bottom));
-    m[3][2] = -((zFar+zNear)/(zFar-zNear));
+    // scale * this scales the first three rows
+    float factors[3] = { x, y, z };
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            m[i][j] *= factors[i];
+        }
+    }
 }
 
 void Matrix::SetPerspectiveProjection(float fov, float aspect, float zNear, float zFar) {
@@ -55,13 +55,11 @@ public:
 		float vertices[] = { x-(width/2), y-(height/2), x+(width/2), y-(height/2), x+(width/2), y+(height/2),
 							 x-(width/2), y-(height/2), x+(width/2), y+(height/2), x-(width/2), y+(height/2) };
 		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
+		ShaderProgram::EnableAttribute(program.positionAttribute);
 		//float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
 		//glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
 		//glEnableVertexAttribArray(program.texCoordAttribute);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		glDisableVertexAttribArray(program.positionAttribute);
 	};
 };
 
@@ -74,13 +72,11 @@ public:
 		float vertices[] = { x - (width / 2), y - (height / 2), x + (width / 2), y - (height / 2), x + (width / 2), y + (height / 2),
 			x - (width / 2), y - (height / 2), x + (width / 2), y + (height / 2), x - (width / 2), y + (height / 2) };
 		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
+		ShaderProgram::EnableAttribute(program.positionAttribute);
 		//float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
 		//glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
 		//glEnableVertexAttribArray(program.texCoordAttribute);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		glDisableVertexAttribArray(program.positionAttribute);
 	};
 };
 
@@ -94,13 +90,11 @@ public:
 		float vertices[] = { x - (width / 2), y - (height / 2), x + (width / 2), y - (height / 2), x + (width / 2), y + (height / 2),
 							 x - (width / 2), y - (height / 2), x + (width / 2), y + (height / 2), x - (width / 2), y + (height / 2) };
 		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
+		ShaderProgram::EnableAttribute(program.positionAttribute);
 		//float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
 		//glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
 		//glEnableVertexAttribArray(program.texCoordAttribute);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		glDisableVertexAttribArray(program.positionAttribute);
 	};
 };
 
@@ -118,9 +112,9 @@ ShaderProgram Setup();
 
 void ProcessEvents(SDL_Event& event, bool& done);
 
-void Update(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities, float elapsed);
+void Update(const Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities, float elapsed);
 
-void Render(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities);
+void Render(const Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities);
 
 void Cleanup();
 
@@ -135,8 +129,7 @@ int main(int argc, char *argv[])
 	ShaderProgram program = Setup();
 
 	// Setup Projection Matrix
-	Matrix projectionMatrix;
-	projectionMatrix.SetOrthoProjection(-3.55f, 3.55f, -2.0f, 2.0f, -1.0f, 1.0f);
+	static constexpr Matrix projectionMatrix = Matrix::OrthoProjection(-3.55f, 3.55f, -2.0f, 2.0f, -1.0f, 1.0f);
 	Matrix modelviewMatrix;
 
 	float lastFrameTicks = 0.0f;
@@ -191,7 +184,7 @@ GLuint LoadTexture(const char *filePath) {
 	}
 	GLuint retTexture;
 	glGenTextures(1, &retTexture);
-	glBindTexture(GL_TEXTURE_2D, retTexture);
+	ShaderProgram::BindTexture(retTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 	// LINEAR
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -259,7 +252,7 @@ void ProcessEvents(SDL_Event & event, bool& done){
 	}
 }
 
-void Update(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities, float elapsed) {
+void Update(const Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities, float elapsed) {
 	const Uint8* keys = SDL_GetKeyboardState(NULL);
 	if (keys[SDL_SCANCODE_W] && entities[0]->y + entities[0]->height / 2 < entities[3]->y-entities[3]->height / 2) {
 		//entities[0]->velocity = elapsed;
@@ -302,14 +295,14 @@ void Update(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& pr
 
 }
 
-void Render(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities) {
+void Render(const Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, std::vector<Entity*> entities) {
 	glClear(GL_COLOR_BUFFER_BIT);
+	// every entity draws in world space, so the matrices are the same for all of them
+	modelviewMatrix.Identity();
+	program.SetModelviewMatrix(modelviewMatrix);
+	program.SetProjectionMatrix(projectionMatrix);
 	for (Entity*& ent : entities) {
-		modelviewMatrix.Identity();
 		//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-		program.SetModelviewMatrix(modelviewMatrix);
-		program.SetProjectionMatrix(projectionMatrix);
-		glUseProgram(program.programID);
 		ent->Draw(program);
 	}
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL.h>
+
+// Overload counters, read them to detect and alarm on a simulation that can't keep up
+struct FrameStats {
+	FrameStats() : frames(0), steps(0), catchUpSteps(0), overloadedFrames(0), droppedSeconds(0.0), dilatedSeconds(0.0) {}
+	unsigned long frames;
+	unsigned long steps;
+	// steps run beyond the first in a frame
+	unsigned long catchUpSteps;
+	// frames that hit maxStepsPerFrame
+	unsigned long overloadedFrames;
+	// backlog thrown away because it didn't fit in the step budget
+	double droppedSeconds;
+	// real time not simulated because the time scale was below 1
+	double dilatedSeconds;
+};
+
+// Paces the main loop without busy-waiting: sleeps until just before the next render deadline
+// on the high resolution counter and spins only for the final stretch. Also owns the fixed step
+// accumulator and bounds how many steps a frame may run so a hitch can't snowball.
+class FrameScheduler {
+public:
+	FrameScheduler(float updateRate, float renderRate);
+
+	void SetUpdateRate(float hz);
+	// 0 renders as fast as the loop can go
+	void SetRenderRate(float hz);
+	float UpdateStep() const { return updateStep; }
+
+	// Blocks until the next frame is due and returns the seconds since the previous call
+	float WaitForNextFrame();
+
+	// Banks elapsed seconds and returns how many fixed steps to run this frame, at most maxStepsPerFrame
+	int Accumulate(float elapsed);
+	// How far the leftover time is into the next step, for interpolating between steps
+	float Alpha() const { return accumulator / updateStep; }
+	float TimeScale() const { return timeScale; }
+
+	const FrameStats& Stats() const { return stats; }
+	void ResetStats() { stats = FrameStats(); }
+
+	// How close to a deadline to stop sleeping and start spinning, covers SDL_Delay's wake-up jitter
+	float spinSeconds;
+	int maxStepsPerFrame;
+	// When overloaded, slow the game clock down to what the budget can simulate instead of only
+	// dropping the backlog, then ease back to real time once frames fit again
+	bool dilateTime;
+	float minTimeScale;
+
+private:
+	Uint64 frequency;
+	Uint64 framePeriod;
+	Uint64 lastFrame;
+	Uint64 nextFrame;
+	float updateStep;
+	float accumulator;
+	float timeScale;
+	FrameStats stats;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+// Scoped CPU timers for looking inside a frame. Build with PROFILE_ENABLED defined to record,
+// without it every PROFILE_ macro compiles to nothing.
+//
+//     void Update(...) {
+//         PROFILE_SCOPE("Update");
+//         ...
+//     }
+//
+// Each thread records into its own fixed ring buffer with no locks, so a scope costs two clock
+// reads and a store. The newest events of every thread can be written out as Chrome trace_event
+// JSON at any time, open it in chrome://tracing or ui.perfetto.dev.
+
+#ifdef PROFILE_ENABLED
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+struct ProfileEvent {
+	const char* name;
+	// nanoseconds since the profiler started
+	uint64_t start;
+	uint64_t end;
+};
+
+// One thread's events, written only by that thread. The oldest are overwritten once it fills.
+class ProfileBuffer {
+public:
+	static const size_t CAPACITY = 1 << 16;
+
+	ProfileBuffer(unsigned int threadId) : threadId(threadId), head(0) {}
+
+	void Push(const char* name, uint64_t start, uint64_t end) {
+		size_t index = head.load(std::memory_order_relaxed);
+		ProfileEvent& event = events[index & (CAPACITY - 1)];
+		event.name = name;
+		event.start = start;
+		event.end = end;
+		head.store(index + 1, std::memory_order_release);
+	}
+
+	const unsigned int threadId;
+	// events written so far, wraps into the buffer with & (CAPACITY - 1)
+	std::atomic<size_t> head;
+	ProfileEvent events[CAPACITY];
+};
+
+class Profiler {
+public:
+	static uint64_t Now();
+	static void Record(const char* name, uint64_t start, uint64_t end) {
+		ThreadBuffer().Push(name, start, end);
+	}
+	// Writes what every thread still has buffered, safe to call while other threads record
+	static bool WriteTrace(const std::string& traceFile);
+
+private:
+	static ProfileBuffer& ThreadBuffer();
+};
+
+class ProfileScope {
+public:
+	ProfileScope(const char* name) : name(name), start(Profiler::Now()) {}
+	~ProfileScope() { Profiler::Record(name, start, Profiler::Now()); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name;
+	uint64_t start;
+};
+
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+// name must outlive the profiler, use a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+#define PROFILE_WRITE(traceFile) Profiler::WriteTrace(traceFile)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_WRITE(traceFile) ((void)0)
+
+#endif
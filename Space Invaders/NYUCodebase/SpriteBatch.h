@@ -0,0 +1,35 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <vector>
+#include "ShaderProgram.h"
+
+// Collects textured quads into one interleaved buffer and draws each run sharing a texture in a single call
+class SpriteBatch {
+public:
+	SpriteBatch();
+	~SpriteBatch();
+	SpriteBatch(const SpriteBatch&) = delete;
+	SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+	// Resets the per-frame counters, the program's matrices must already be set
+	void Begin(ShaderProgram& program);
+	// Queues an axis-aligned quad centered on (x, y) sampling the (u, v, uWidth, vHeight) region of texture
+	void Draw(GLuint texture, float x, float y, float width, float height, float u, float v, float uWidth, float vHeight);
+	void End();
+
+	// Draw calls and sprites submitted since the last Begin()
+	int drawCalls;
+	int sprites;
+
+private:
+	void Flush();
+
+	ShaderProgram* program;
+	GLuint texture;
+	GLuint vertexBuffer;
+	std::vector<float> vertices;
+};
@@ -9,12 +9,19 @@
 #include <SDL_image.h>
 #include <vector>
 #include <array>
+#include <cstdint>
+#include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 // 60 FPS (1.0f/60.0f) (update sixty times a second)
 #define FIXED_TIMESTEP 0.0166666f
+// Render at most sixty frames a second, 0 for uncapped
+#define RENDER_RATE 60.0f
 #include "stb_image.h"
 #include "Matrix.h"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "FrameScheduler.h"
+#include "Profiler.h"
 
 
 #ifdef _WINDOWS
@@ -38,29 +45,6 @@ public:
 		textureID(textureID), u(coords[0]), v(coords[1]), width(coords[2]), height(coords[3]), size(size) {};
 	SheetSprite(unsigned int textureID, float u, float v, float width, float height, float size) : 
 		textureID(textureID), u(u), v(v), width(width), height(height), size(size) {}
-	void Draw(ShaderProgram& program) {
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		GLfloat texCoords[] = {
-			u, v + height,
-			u + width, v + height,
-			u + width, v,
-			u, v + height,
-			u + width, v,
-			u, v
-		};
-		float aspect = width / height;
-		float vertices[] = {
-			-0.5f * size * aspect, -0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, 0.5f * size,
-			0.5f * size * aspect, 0.5f * size,
-			-0.5f * size * aspect, -0.5f * size ,
-			0.5f * size * aspect, -0.5f * size };
-		// draw our arrays
-		glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
-		glEnableVertexAttribArray(program.texCoordAttribute);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-	}
 	float size;
 	unsigned int textureID;
 	float u;
@@ -72,29 +56,29 @@ public:
 // 3D Vector
 class Vector3 {
 public:
-	Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
-	Vector3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
-	Vector3& operator=(Vector3 const& rhs) {
+	constexpr Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
+	constexpr Vector3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
+	constexpr Vector3& operator=(Vector3 const& rhs) {
 		x = rhs.x;
 		y = rhs.y;
 		z = rhs.z;
 		return *this;
 	}
-	Vector3 operator+(Vector3 const& rhs) const {
+	constexpr Vector3 operator+(Vector3 const& rhs) const {
 		Vector3 out(x + rhs.x, y + rhs.y, z + rhs.z);
 		return out;
 	}
-	Vector3& operator+=(Vector3 const& rhs) {
+	constexpr Vector3& operator+=(Vector3 const& rhs) {
 		x += rhs.x;
 		y += rhs.y;
 		z += rhs.z;
 		return *this;
 	}
-	Vector3 operator*(const float num) const {
+	constexpr Vector3 operator*(const float num) const {
 		Vector3 out(x*num, y*num, z*num);
 		return out;
 	}
-	Vector3& operator*=(const float num) {
+	constexpr Vector3& operator*=(const float num) {
 		x *= num;
 		y *= num;
 		z *= num;
@@ -103,33 +87,84 @@ public:
 	float x, y, z;
 };
 
-// Basic Game Object
-class Entity {
+// Names an entity of a store. Still safe to hold after the entity is destroyed: its slot gets a
+// new generation when freed, so Valid() turns false instead of the handle finding a stranger.
+struct EntityHandle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+// A group of entities as parallel arrays, element i of each belonging to entity i, so the update
+// pass streams through positions and velocities alone. Entities keep their index for as long as
+// they live and a destroyed one's slot goes to the next Create, so the arrays never shift.
+class EntityStore {
 public:
 	enum ENTITY_TYPE { ENTITY_PLAYER, ENTITY_ENEMY, ENTITY_LETTER, ENTITY_STAR, ENTITY_BULLET };
-	Entity(SheetSprite sprite, ENTITY_TYPE type, bool alive) : sprite(sprite), type(type), alive(alive) {};
-	Entity(float x, float y, float z, float width, float height, float length, float vX, float vY, float vZ, float aX, float aY, float aZ, SheetSprite sprite, ENTITY_TYPE type, bool alive) :
-		position(x, y, z), size(width, height, length), velocity(vX, vY, vZ), acceleration(aX, aY, aZ), sprite(sprite), type(type), alive(alive) {};
-	Entity(Vector3 position, Vector3 size, Vector3 velocity, Vector3 acceleration, SheetSprite sprite, ENTITY_TYPE type, bool alive) :
-		position(position), size(size), velocity(velocity), acceleration(acceleration), sprite(sprite), type(type), alive(alive) {};
-	void Draw(ShaderProgram& program) {
-		//glBindTexture(GL_TEXTURE_2D, textureId);
-		float vertices[] = { position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2),
-			position.x - (size.x / 2), position.y - (size.y / 2), position.x + (size.x / 2), position.y + (size.y / 2), position.x - (size.x / 2), position.y + (size.y / 2) };
-		glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-		glEnableVertexAttribArray(program.positionAttribute);
-		sprite.Draw(program);
-
-		glDisableVertexAttribArray(program.positionAttribute);
-		glDisableVertexAttribArray(program.texCoordAttribute);
+
+	EntityHandle Create(ENTITY_TYPE entityType, const SheetSprite& entitySprite, Vector3 position, Vector3 size, Vector3 velocity, bool isAlive) {
+		size_t index;
+		if (freeSlots.empty()) {
+			index = Size();
+			x.push_back(0.0f); y.push_back(0.0f);
+			velocityX.push_back(0.0f); velocityY.push_back(0.0f);
+			width.push_back(0.0f); height.push_back(0.0f);
+			type.push_back(0); alive.push_back(0);
+			sprite.push_back(entitySprite);
+			generation.push_back(0);
+			used.push_back(0);
+		}
+		else {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		x[index] = position.x;
+		y[index] = position.y;
+		velocityX[index] = velocity.x;
+		velocityY[index] = velocity.y;
+		width[index] = size.x;
+		height[index] = size.y;
+		type[index] = (uint8_t)entityType;
+		alive[index] = isAlive;
+		sprite[index] = entitySprite;
+		used[index] = 1;
+		return Handle(index);
+	}
+	void Destroy(EntityHandle handle) {
+		if (!Valid(handle)) return;
+		alive[handle.index] = false;
+		used[handle.index] = 0;
+		// any handle still out there no longer matches
+		++generation[handle.index];
+		freeSlots.push_back(handle.index);
 	}
-	Vector3 position;
-	Vector3 size;
-	Vector3 velocity;
-	Vector3 acceleration;
-	SheetSprite sprite;
-	ENTITY_TYPE type;
-	bool alive;
+	bool Valid(EntityHandle handle) const {
+		return handle.index < Size() && used[handle.index] && generation[handle.index] == handle.generation;
+	}
+	EntityHandle Handle(size_t index) const { return { (uint32_t)index, generation[index] }; }
+	// Slots, including freed ones
+	size_t Size() const { return x.size(); }
+
+	void Draw(SpriteBatch& batch, size_t index) const {
+		const SheetSprite& look = sprite[index];
+		batch.Draw(look.textureID, x[index], y[index], width[index], height[index], look.u, look.v, look.width, look.height);
+	}
+
+	// read or written by every step
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> width;
+	std::vector<float> height;
+	std::vector<uint8_t> type;
+	std::vector<uint8_t> alive;
+	// only drawing reads these
+	std::vector<SheetSprite> sprite;
+
+private:
+	std::vector<uint32_t> generation;
+	std::vector<uint8_t> used;
+	std::vector<uint32_t> freeSlots;
 };
 
 // Game States
@@ -137,8 +172,8 @@ class GameState {
 public:
 	enum STATE_TYPE { STATE_MENU, STATE_GAME };
 	GameState(STATE_TYPE type) : type(type) {}
-	std::vector<Entity*> entities;
-	std::vector<Entity*> bgEntities;
+	EntityStore entities;
+	EntityStore bgEntities;
 	STATE_TYPE type;
 };
 
@@ -153,7 +188,10 @@ GLuint LoadTexture(const char *filePath);
 
 float randf(float a, float b);
 
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height);
+// Where a sprite sits on its sheet as u, v, width and height, usable in constant expressions
+constexpr std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height) {
+	return { { float(xPx) / sheetWidth, float(yPx) / sheetHeight, float(width) / sheetWidth, float(height) / sheetHeight } };
+}
 
 ShaderProgram Setup();
 
@@ -163,7 +201,7 @@ void ProcessEvents(SDL_Event& event, bool& done, GameState*& currentState, std::
 
 void Update(GameState* state, float elapsed);
 
-void Render(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, GameState* state);
+void Render(const Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state);
 
 void Cleanup();
 
@@ -178,11 +216,9 @@ int main(int argc, char *argv[])
 	ShaderProgram program = Setup();
 
 	// Setup Projection Matrix
-	Matrix projectionMatrix;
-	projectionMatrix.SetOrthoProjection(-3.55f, 3.55f, -2.0f, 2.0f, -1.0f, 1.0f);
+	static constexpr Matrix projectionMatrix = Matrix::OrthoProjection(-3.55f, 3.55f, -2.0f, 2.0f, -1.0f, 1.0f);
 	Matrix modelviewMatrix;
-
-	float lastFrameTicks = 0.0f;
+	SpriteBatch batch;
 
 	//Instantiate Objects, Textures, and States
 	
@@ -191,25 +227,26 @@ int main(int argc, char *argv[])
 	GameState* currentState = states[0];
 	SDL_Event event;
 	bool done = false;
-	float accumulator = 0.0f;
+	FrameScheduler scheduler(1.0f / FIXED_TIMESTEP, RENDER_RATE);
+	float reportTimer = 0.0f;
 	while (!done) {
+		// sleeps instead of spinning until the next frame is due
+		float elapsed = scheduler.WaitForNextFrame();
+		PROFILE_SCOPE("Frame");
 		ProcessEvents(event, done, currentState, states);
 
-		float ticks = static_cast<float>(SDL_GetTicks()) / 1000.0f;
-		float elapsed = ticks - lastFrameTicks;
-		lastFrameTicks = ticks;
-		// get elapsed time
-		elapsed += accumulator;
-		if (elapsed < FIXED_TIMESTEP) {
-			accumulator = elapsed;
-			continue;
+		// bounded so a long hitch can't turn into an ever growing catch-up
+		int steps = scheduler.Accumulate(elapsed);
+		for (int i = 0; i < steps; ++i) {
+			Update(currentState, scheduler.UpdateStep());
 		}
-		while (elapsed >= FIXED_TIMESTEP) {
-			Update(currentState, FIXED_TIMESTEP);
-			elapsed -= FIXED_TIMESTEP;
+		Render(projectionMatrix, modelviewMatrix, program, batch, currentState);
+		// once a second, what the last frame cost the batch
+		reportTimer += elapsed;
+		if (reportTimer >= 1.0f) {
+			std::cout << "Draw calls: " << batch.drawCalls << ", sprites: " << batch.sprites << std::endl;
+			reportTimer = 0.0f;
 		}
-		accumulator = elapsed;
-		Render(projectionMatrix, modelviewMatrix, program, currentState);
 	}
 
 
@@ -232,7 +269,7 @@ GLuint LoadTexture(const char *filePath) {
 	}
 	GLuint retTexture;
 	glGenTextures(1, &retTexture);
-	glBindTexture(GL_TEXTURE_2D, retTexture);
+	ShaderProgram::BindTexture(retTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 	// LINEAR
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -244,15 +281,18 @@ GLuint LoadTexture(const char *filePath) {
 	return retTexture;
 }
 
-bool isCollidingRect(Entity* r1, Entity* r2){
+bool isCollidingRect(const EntityStore& entities, size_t r1, size_t r2){
+	const std::vector<float>& x = entities.x;
+	const std::vector<float>& y = entities.y;
+	const std::vector<float>& height = entities.height;
 	// Is r1 bottom > r2 top?
-	if (r1->position.y - r1->size.y / 2 > r2->position.y + r2->size.y / 2) return false;
+	if (y[r1] - height[r1] / 2 > y[r2] + height[r2] / 2) return false;
 	// Is r1 top < r2 bottom?
-	if (r1->position.y + r1->size.y / 2 < r2->position.y - r2->size.y / 2) return false;
+	if (y[r1] + height[r1] / 2 < y[r2] - height[r2] / 2) return false;
 	// Is r1 left > r2 right?
-	if (r1->position.x - r1->size.y / 2 > r2->position.x + r2->size.y / 2) return false;
+	if (x[r1] - height[r1] / 2 > x[r2] + height[r2] / 2) return false;
 	// Is r1 right < r2 left?
-	if (r1->position.x + r1->size.y / 2 < r2->position.x - r2->size.y / 2) return false;
+	if (x[r1] + height[r1] / 2 < x[r2] - height[r2] / 2) return false;
 
 	return true;
 }
@@ -268,16 +308,6 @@ float randf(float a, float b) {
 	return a + r;
 }
 
-std::array<float, 4> pxToUV(int sheetWidth, int sheetHeight, int xPx, int yPx, int width, int height)
-{
-	std::array<float, 4> out;
-	out[0] = float(xPx) / sheetWidth;
-	out[1] = float(yPx) / sheetHeight;
-	out[2] = float(width) / sheetWidth;
-	out[3] = float(height) / sheetHeight;
-	return out;
-}
-
 
 /**********************************************
  **********************************************
@@ -315,12 +345,11 @@ ShaderProgram Setup() {
 std::vector<GameState*> Instantiate() {
 	// Load background and textures
 	unsigned int spriteSheetTexture = LoadTexture("Sprites.png");
-	int sheetWidth = 536;
-	int sheetHeight = 686;
+	constexpr int sheetWidth = 536;
+	constexpr int sheetHeight = 686;
 	Vector3 bgStarPosition(0.0f, 2.0f, 0.0f);
 	Vector3 const bgStarVelocity(0.0f, -1.0f, 0.0f);
 	Vector3 const bgStarSize(0.01f, 0.01f, 0.0f);
-	Vector3 const bgStarAcceleration(0.0f, 0.0f, 0.0f);
 	SheetSprite const starSprite(spriteSheetTexture, pxToUV(sheetWidth, sheetHeight, 0, 240, 1, 1), 1.0f);
 	SheetSprite const logoSprite(spriteSheetTexture, pxToUV(sheetWidth, sheetHeight, 437, 500, 99, 59), 1.0f);
 	std::vector<SheetSprite> sprites;
@@ -339,11 +368,11 @@ std::vector<GameState*> Instantiate() {
 
 	for (int i = 0; i < 30; ++i) {
 		bgStarPosition = Vector3(randf(-3.55f, 3.55f), randf(-2.0f, 2.0f), 0.0f);
-		states[0]->bgEntities.push_back(new Entity(bgStarPosition, bgStarSize, bgStarVelocity, bgStarAcceleration, starSprite, Entity::ENTITY_STAR, true));
+		states[0]->bgEntities.Create(EntityStore::ENTITY_STAR, starSprite, bgStarPosition, bgStarSize, bgStarVelocity, true);
 	}
-	states[0]->entities.push_back(new Entity(0.0f, 0.0f, 0.0f, 2.0f, 1.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, logoSprite, Entity::ENTITY_LETTER, true));
+	states[0]->entities.Create(EntityStore::ENTITY_LETTER, logoSprite, Vector3(0.0f, 0.0f, 0.0f), Vector3(2.0f, 1.1f, 0.0f), Vector3(), true);
 
-	states[1]->entities.push_back(new Entity(0.0f, -1.7f, 0.0f, 0.3f, 0.2f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, sprites[0], Entity::ENTITY_PLAYER, true));
+	states[1]->entities.Create(EntityStore::ENTITY_PLAYER, sprites[0], Vector3(0.0f, -1.7f, 0.0f), Vector3(0.3f, 0.2f, 0.0f), Vector3(), true);
 	float enemyWidth = 0.3f;
 	float enemyHeight = 0.2f;
 	float spacing = 0.5f;
@@ -352,46 +381,54 @@ std::vector<GameState*> Instantiate() {
 			Vector3 enemyPosition(-1.75f + spacing*j, 1.7f - spacing*i, 0.0f);
 			Vector3 enemySize(enemyWidth, enemyHeight, 0.0f);
 			Vector3 enemyVelocity(0.3f, 0.0f, 0.0f);
-			Vector3 zero;
-			states[1]->entities.push_back(new Entity(enemyPosition, enemySize, enemyVelocity, zero, sprites[i + 3], Entity::ENTITY_ENEMY, true));
+			states[1]->entities.Create(EntityStore::ENTITY_ENEMY, sprites[i + 3], enemyPosition, enemySize, enemyVelocity, true);
 		}
 	}
 	for (int i = 0; i < 10; ++i) {
 		Vector3 offScreen(4.0f, 0.0f, 0.0f);
 		Vector3 bulletSize(0.025f, 0.15f, 0.0f);
-		Vector3 zero;
-		states[1]->entities.push_back(new Entity(offScreen, bulletSize, zero, zero, starSprite, Entity::ENTITY_BULLET, false));
+		states[1]->entities.Create(EntityStore::ENTITY_BULLET, starSprite, offScreen, bulletSize, Vector3(), false);
 	}
 	for (int i = 0; i < 10; ++i) {
 		Vector3 offScreen(0.0f, 3.0f, 0.0f);
 		Vector3 bulletSize(0.07f, 0.2f, 0.0f);
-		Vector3 zero;
-		states[1]->entities.push_back(new Entity(offScreen, bulletSize, zero, zero, sprites[2], Entity::ENTITY_BULLET, false));
+		states[1]->entities.Create(EntityStore::ENTITY_BULLET, sprites[2], offScreen, bulletSize, Vector3(), false);
 	}
 	return states;
 }
 
 void ProcessEvents(SDL_Event & event, bool& done, GameState*& currentState, std::vector<GameState*>& states){
+	PROFILE_SCOPE("ProcessEvents");
 	// SDL Event Loop
 	while (SDL_PollEvent(&event)) {
 		// Quit or Close Event
 		if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
 			done = true;
 		}
+		// F9 saves what the profiler has so far
+		if (event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_F9) {
+			PROFILE_WRITE("trace.json");
+			continue;
+		}
+		if (event.type == SDL_KEYUP && event.key.keysym.scancode == SDL_SCANCODE_F9) {
+			continue;
+		}
 		if (event.type == SDL_KEYUP) {
 			if (currentState->type == GameState::STATE_MENU) {
 				currentState = states[1];
 				currentState->bgEntities = states[0]->bgEntities;
 			}
-			else if (currentState->type == GameState::STATE_GAME && currentState->entities[0]->alive) {
+			else if (currentState->type == GameState::STATE_GAME && currentState->entities.alive[0]) {
 				if (event.key.keysym.scancode == SDL_SCANCODE_SPACE) {
+					EntityStore& entities = currentState->entities;
 					int i = 41;
-					while (currentState->entities[i]->alive && i <= 51) ++i;
+					while (entities.alive[i] && i <= 51) ++i;
 					if (i < 51) {
-						Entity* bullet = currentState->entities[i];
-						bullet->alive = true;
-						bullet->position = Vector3(currentState->entities[0]->position.x, currentState->entities[0]->position.y + 0.2f, 0.0f);
-						bullet->velocity = Vector3(0.0f, 1.5f, 0.0f);
+						entities.alive[i] = true;
+						entities.x[i] = entities.x[0];
+						entities.y[i] = entities.y[0] + 0.2f;
+						entities.velocityX[i] = 0.0f;
+						entities.velocityY[i] = 1.5f;
 					}
 				}
 			}
@@ -400,36 +437,39 @@ void ProcessEvents(SDL_Event & event, bool& done, GameState*& currentState, std:
 	}
 
 	// Keyboard Polling
+	// the player is entity 0, then 40 enemies, 10 player bullets and 10 enemy bullets
+	EntityStore& entities = currentState->entities;
 	const Uint8* keys = SDL_GetKeyboardState(NULL);
-	if (keys[SDL_SCANCODE_RIGHT] && currentState->entities[0]->position.x + currentState->entities[0]->size.x / 2 < 3.55) {
-		currentState->entities[0]->velocity.x = 2;
+	if (keys[SDL_SCANCODE_RIGHT] && entities.x[0] + entities.width[0] / 2 < 3.55) {
+		entities.velocityX[0] = 2;
 	}
-	if (keys[SDL_SCANCODE_LEFT] && currentState->entities[0]->position.x - currentState->entities[0]->size.x / 2 > -3.55) {
-		currentState->entities[0]->velocity.x = -2;
+	if (keys[SDL_SCANCODE_LEFT] && entities.x[0] - entities.width[0] / 2 > -3.55) {
+		entities.velocityX[0] = -2;
 	}
 	
 	// Collisions and other events
 	if (currentState->type == GameState::STATE_GAME) {
+		PROFILE_SCOPE("Collision");
 		// Turn the enemies
 		bool turn = false;
 		for (int i = 0; i < 8; ++i) {
 			if (turn) break;
 			for (int j = 0; j < 5; ++j) {
-				if (turn = (currentState->entities[1 + i * 5 + j]->position.x > 3.4 && currentState->entities[1 + i * 5 + j]->velocity.x > 0)
-					|| (currentState->entities[1 + i * 5 + j]->position.x < -3.4 && currentState->entities[1 + i * 5 + j]->velocity.x < 0)) break;
+				if (turn = (entities.x[1 + i * 5 + j] > 3.4 && entities.velocityX[1 + i * 5 + j] > 0)
+					|| (entities.x[1 + i * 5 + j] < -3.4 && entities.velocityX[1 + i * 5 + j] < 0)) break;
 			}
 		}
 		if (turn) {
 			for (int i = 1; i < 41; ++i) {
-				currentState->entities[i]->velocity.x *= -1;
+				entities.velocityX[i] *= -1;
 			}
 		}
 
 		// Player Bullet Collision
 		for(int i = 41; i < 51; ++i) {
 			for(int j = 1; j < 41; ++j) {
-				if (currentState->entities[i]->alive && currentState->entities[j]->alive &&isCollidingRect(currentState->entities[i], currentState->entities[j])) {
-					currentState->entities[i]->alive = currentState->entities[j]->alive = false;
+				if (entities.alive[i] && entities.alive[j] && isCollidingRect(entities, i, j)) {
+					entities.alive[i] = entities.alive[j] = false;
 				}
 			}
 		}
@@ -437,22 +477,23 @@ void ProcessEvents(SDL_Event & event, bool& done, GameState*& currentState, std:
 		// Enemy Bullet Generation
 		if (randf(0.0f, 1.0f) < 0.0005) {
 			int i = 51;
-			while (currentState->entities[i]->alive && i <= 57) ++i;
+			while (entities.alive[i] && i <= 57) ++i;
 			if (i < 57) {
-				Entity* bullet = currentState->entities[i];
-				bullet->alive = true;
+				entities.alive[i] = true;
 				int randIdx = rand() % 40 + 1;
-				while(!currentState->entities[randIdx]->alive) randIdx = rand() % 40 + 1;
-				bullet->position = Vector3(currentState->entities[randIdx]->position.x, currentState->entities[randIdx]->position.y - 0.2f, 0.0f);
-				bullet->velocity = Vector3(0.0f, -1.5f, 0.0f);
+				while(!entities.alive[randIdx]) randIdx = rand() % 40 + 1;
+				entities.x[i] = entities.x[randIdx];
+				entities.y[i] = entities.y[randIdx] - 0.2f;
+				entities.velocityX[i] = 0.0f;
+				entities.velocityY[i] = -1.5f;
 			}
 		}
 
 		// Enemy Bullet Collision
 		for(int i = 51; i < 57; ++i) {
 			if (done) break;
-			if (isCollidingRect(currentState->entities[0], currentState->entities[i])) {
-				currentState->entities[0]->alive = currentState->entities[i]->alive = false;
+			if (isCollidingRect(entities, 0, i)) {
+				entities.alive[0] = entities.alive[i] = false;
 				done = true;
 			}
 		}
@@ -462,94 +503,85 @@ void ProcessEvents(SDL_Event & event, bool& done, GameState*& currentState, std:
 			bool allDead = true;
 			for (int i = 1; i < 41; ++i) {
 				if (!allDead) break;
-				if (currentState->entities[i]->alive) allDead = false;
+				if (entities.alive[i]) allDead = false;
 			}
 			done = allDead;
 		}
 	}
 }
 
+// Drifts the stars down the screen, wrapping each one back above the top once it falls off
+static void moveStars(EntityStore& stars, float elapsed) {
+	for (size_t ent = 0; ent < stars.Size(); ++ent) {
+		stars.x[ent] += stars.velocityX[ent] * elapsed;
+		stars.y[ent] += stars.velocityY[ent] * elapsed;
+		if (stars.y[ent] < -2.0f) {
+			Vector3 respawn(randf(-3.55f, 3.55f), 2.0f + randf(0.0f, 1.0f), 0.0f);
+			stars.x[ent] = respawn.x;
+			stars.y[ent] = respawn.y;
+		}
+	}
+}
+
 void Update(GameState* state, float elapsed) {
+	PROFILE_SCOPE("Update");
+	EntityStore& entities = state->entities;
 	switch(state->type)
 	{
 	case GameState::STATE_MENU :
-		for (Entity*& ent : state->entities) {
-			//ent->velocity += ent->acceleration;
-			//ent->position += ent->velocity * elapsed;
-
-		}
-		for (Entity*& ent : state->bgEntities) {
-			ent->position += ent->velocity * elapsed;
-			if(ent->position.y < -2.0f) {
-				ent->position = Vector3(randf(-3.55f, 3.55f), 2.0f + randf(0.0f, 1.0f), 0.0f);
-			}
-		}
+		moveStars(state->bgEntities, elapsed);
 	case GameState::STATE_GAME :
-		for (Entity*& ent : state->entities) {
-			if (ent->alive) {
-				ent->position += ent->velocity * elapsed;
+		for (size_t ent = 0; ent < entities.Size(); ++ent) {
+			if (entities.alive[ent]) {
+				entities.x[ent] += entities.velocityX[ent] * elapsed;
+				entities.y[ent] += entities.velocityY[ent] * elapsed;
 			}
-			if (ent->type == Entity::ENTITY_PLAYER) ent->velocity = Vector3(0.0f, 0.0f, 0.0f);
-			else if (ent->type == Entity::ENTITY_BULLET) {
-				if (ent->position.y > 3.0f || ent->position.y < -3.0f) ent->alive = false;
-			}
-		}
-		for (Entity*& ent : state->bgEntities) {
-			ent->position += ent->velocity * elapsed;
-			if (ent->position.y < -2.0f) {
-				ent->position = Vector3(randf(-3.55f, 3.55f), 2.0f + randf(0.0f, 1.0f), 0.0f);
+			if (entities.type[ent] == EntityStore::ENTITY_PLAYER) entities.velocityX[ent] = entities.velocityY[ent] = 0.0f;
+			else if (entities.type[ent] == EntityStore::ENTITY_BULLET) {
+				if (entities.y[ent] > 3.0f || entities.y[ent] < -3.0f) entities.alive[ent] = false;
 			}
 		}
+		moveStars(state->bgEntities, elapsed);
 	}
 
 
 }
 
-void Render(Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, GameState* state) {
+void Render(const Matrix& projectionMatrix, Matrix& modelviewMatrix, ShaderProgram& program, SpriteBatch& batch, GameState* state) {
+	PROFILE_SCOPE("Render");
 	glClear(GL_COLOR_BUFFER_BIT);
+	modelviewMatrix.Identity();
+	program.SetModelviewMatrix(modelviewMatrix);
+	program.SetProjectionMatrix(projectionMatrix);
+	batch.Begin(program);
 	switch(state->type)
 	{
 	case GameState::STATE_MENU :
-		for (Entity*& ent : state->entities) {
-			modelviewMatrix.Identity();
-			//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-			program.SetModelviewMatrix(modelviewMatrix);
-			program.SetProjectionMatrix(projectionMatrix);
-			glUseProgram(program.programID);
-			ent->Draw(program);
+		for (size_t ent = 0; ent < state->entities.Size(); ++ent) {
+			state->entities.Draw(batch, ent);
 		}
-		for (Entity*& ent : state->bgEntities) {
-			modelviewMatrix.Identity();
-			//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-			program.SetModelviewMatrix(modelviewMatrix);
-			program.SetProjectionMatrix(projectionMatrix);
-			glUseProgram(program.programID);
-			ent->Draw(program);
+		for (size_t ent = 0; ent < state->bgEntities.Size(); ++ent) {
+			state->bgEntities.Draw(batch, ent);
 		}
 	case GameState::STATE_GAME :
-		for (Entity*& ent : state->entities) {
-			if (ent->alive) {
-				modelviewMatrix.Identity();
-				//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-				program.SetModelviewMatrix(modelviewMatrix);
-				program.SetProjectionMatrix(projectionMatrix);
-				glUseProgram(program.programID);
-				ent->Draw(program);
+		for (size_t ent = 0; ent < state->entities.Size(); ++ent) {
+			if (state->entities.alive[ent]) {
+				state->entities.Draw(batch, ent);
 			}
 		}
-		for (Entity*& ent : state->bgEntities) {
-			modelviewMatrix.Identity();
-			//modelviewMatrix.Translate(ent->direction_x, ent->direction_y, 0.0f);
-			program.SetModelviewMatrix(modelviewMatrix);
-			program.SetProjectionMatrix(projectionMatrix);
-			glUseProgram(program.programID);
-			ent->Draw(program);
+		for (size_t ent = 0; ent < state->bgEntities.Size(); ++ent) {
+			state->bgEntities.Draw(batch, ent);
 		}
 	}
+	batch.End();
 
-	SDL_GL_SwapWindow(displayWindow);
+	{
+		PROFILE_SCOPE("SwapWindow");
+		SDL_GL_SwapWindow(displayWindow);
+	}
 }
 
 void Cleanup() {
+	PROFILE_WRITE("trace.json");
 	SDL_Quit();
 }
\ No newline at end of file